@@ -0,0 +1,87 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <stdint.h>
+
+// IMA-ADPCM, 4 bits per sample, in the mono block layout of WAV format 0x11:
+// a 4-byte header holds the block's first sample and step index, the rest are
+// codes, two per byte with the low nibble first. A block of n bytes holds
+// (n - 4) * 2 + 1 samples and decodes without the blocks before it.
+
+const int16_t ADPCM_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107,
+    118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894,
+    6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+const int8_t ADPCM_INDEX_STEPS[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+inline int adpcm_samples_per_block(int blockAlign) { return (blockAlign - 4) * 2 + 1; }
+
+// codec state between samples
+struct AdpcmState {
+    int32_t predictor = 0;
+    int32_t index = 0;
+
+    int16_t decode(uint8_t code) {
+        const int32_t step = ADPCM_STEPS[index];
+        int32_t diff = step >> 3;
+        if (code & 4) diff += step;
+        if (code & 2) diff += step >> 1;
+        if (code & 1) diff += step >> 2;
+        predictor += code & 8 ? -diff : diff;
+        predictor = predictor > 32767 ? 32767 : (predictor < -32768 ? -32768 : predictor);
+        index += ADPCM_INDEX_STEPS[code];
+        index = index < 0 ? 0 : (index > 88 ? 88 : index);
+        return static_cast<int16_t>(predictor);
+    }
+
+    // code that moves the predictor closest to sample, the state follows the decoder
+    uint8_t encode(int16_t sample) {
+        int32_t diff = sample - predictor;
+        uint8_t code = 0;
+        if (diff < 0) {
+            code = 8;
+            diff = -diff;
+        }
+        int32_t step = ADPCM_STEPS[index];
+        if (diff >= step) { code |= 4; diff -= step; }
+        step >>= 1;
+        if (diff >= step) { code |= 2; diff -= step; }
+        step >>= 1;
+        if (diff >= step) code |= 1;
+        decode(code);
+        return code;
+    }
+};
+
+// decode one block into out, returns the number of samples
+inline int adpcm_decode_block(const uint8_t* block, int blockAlign, int16_t* out) {
+    AdpcmState state;
+    state.predictor = static_cast<int16_t>(block[0] | (block[1] << 8));
+    state.index = block[2] > 88 ? 88 : block[2];
+    out[0] = static_cast<int16_t>(state.predictor);
+    int n = 1;
+    for (int i = 4; i < blockAlign; i++) {
+        out[n++] = state.decode(block[i] & 0x0F);
+        out[n++] = state.decode(block[i] >> 4);
+    }
+    return n;
+}
+
+// encode samplesPerBlock samples into one block, the step index carries over between blocks in state
+inline void adpcm_encode_block(const int16_t* in, int blockAlign, AdpcmState& state, uint8_t* block) {
+    state.predictor = in[0];
+    block[0] = static_cast<uint8_t>(in[0] & 0xFF);
+    block[1] = static_cast<uint8_t>((in[0] >> 8) & 0xFF);
+    block[2] = static_cast<uint8_t>(state.index);
+    block[3] = 0;
+    int n = 1;
+    for (int i = 4; i < blockAlign; i++) {
+        uint8_t low = state.encode(in[n++]);
+        uint8_t high = state.encode(in[n++]);
+        block[i] = static_cast<uint8_t>(low | (high << 4));
+    }
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef ADPCM_LOOP_H
+#define ADPCM_LOOP_H
+
+#include <atomic>
+#include <string.h>
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "adpcm.h"
+
+// plays a mono IMA-ADPCM WAV from SPIFFS as an endless loop, e.g. a recording
+// of a fan or rain uploaded through the web interface. The file is streamed:
+// each channel reads ADPCM_READ_AHEAD_BLOCKS blocks at a time into a small
+// buffer and decodes one block when the last one has been played, so neither
+// the file nor its decoded PCM is ever held in RAM. In stereo the right channel
+// plays the same loop half a loop later.
+//
+// The render path and the control task (boot, web upload) share the file.
+// The render path only takes it with a try-lock and plays silence when the
+// control task holds it; the control task only opens and closes it under the lock.
+class AdpcmLoopPlayer {
+private:
+    enum Access { FREE, RENDERING, LOCKED };
+
+    struct Reader {
+        uint32_t block = 0;      // next block to decode
+        uint32_t aheadFirst = 0; // block in ahead[0]
+        uint32_t aheadCount = 0;
+        int32_t position = 0;    // in samples
+        int32_t count = 0;
+        int16_t samples[(ADPCM_MAX_BLOCK_ALIGN - 4) * 2 + 1];
+        uint8_t ahead[ADPCM_READ_AHEAD_BLOCKS * ADPCM_MAX_BLOCK_ALIGN];
+    };
+
+    const char* path;
+    fs::File file;
+    fs::File uploadFile;
+    std::atomic<int> access{FREE};
+    bool loaded = false;
+    uint32_t dataOffset = 0;
+    uint32_t blockAlign = 0;
+    uint32_t blocks = 0;
+    int32_t lastBlockSamples = 0;
+    Reader left;
+    Reader right;
+
+    static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+    static uint16_t le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+    void lock() {
+        int expected = FREE;
+        while (!access.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire)) {
+            expected = FREE;
+            delay(1);
+        }
+    }
+
+    void unlock() { access.store(FREE, std::memory_order_release); }
+
+    void restart() {
+        left.block = 0;
+        right.block = blocks / 2;
+        left.position = left.count = right.position = right.count = 0;
+        left.aheadCount = right.aheadCount = 0;
+    }
+
+    // parse the WAV header, the file must match the player's format
+    bool parse() {
+        uint8_t header[12];
+        if (file.read(header, 12) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) return false;
+        uint32_t position = 12, samples = 0, dataSize = 0;
+        dataOffset = 0;
+        bool format = false;
+        uint8_t chunk[8];
+        while (file.seek(position) && file.read(chunk, 8) == 8) {
+            const uint32_t size = le32(chunk + 4);
+            if (!memcmp(chunk, "fmt ", 4)) {
+                uint8_t fmt[20];
+                if (size < 20 || file.read(fmt, 20) != 20) return false;
+                blockAlign = le16(fmt + 12);
+                format = le16(fmt) == 0x11 && le16(fmt + 2) == 1 && le32(fmt + 4) == AUDIO_SAMPLE_RATE && le16(fmt + 14) == 4 &&
+                         blockAlign > 4 && blockAlign <= ADPCM_MAX_BLOCK_ALIGN && le16(fmt + 18) == adpcm_samples_per_block(blockAlign);
+            } else if (!memcmp(chunk, "fact", 4)) {
+                uint8_t fact[4];
+                if (size >= 4 && file.read(fact, 4) == 4) samples = le32(fact);
+            } else if (!memcmp(chunk, "data", 4)) {
+                dataOffset = position + 8;
+                dataSize = size;
+                break;
+            }
+            position += 8 + size + (size & 1);
+        }
+        if (!format || !dataOffset) return false;
+        blocks = dataSize / blockAlign;
+        if (blocks == 0) return false;
+        const int32_t perBlock = adpcm_samples_per_block(blockAlign);
+        lastBlockSamples = perBlock;
+        if (samples > static_cast<uint32_t>(blocks - 1) * perBlock && samples < static_cast<uint32_t>(blocks) * perBlock) {
+            lastBlockSamples = samples - (blocks - 1) * perBlock;
+        }
+        return true;
+    }
+
+    // decode the reader's next block, refilling its buffer when the block is not in it
+    bool nextBlock(Reader& r) {
+        if (r.block >= blocks) r.block = 0;
+        if (r.block < r.aheadFirst || r.block >= r.aheadFirst + r.aheadCount) {
+            uint32_t count = blocks - r.block < ADPCM_READ_AHEAD_BLOCKS ? blocks - r.block : ADPCM_READ_AHEAD_BLOCKS;
+            if (!file.seek(dataOffset + r.block * blockAlign)) return false;
+            r.aheadFirst = r.block;
+            r.aheadCount = file.read(r.ahead, count * blockAlign) / blockAlign;
+            if (r.aheadCount == 0) return false;
+        }
+        r.count = adpcm_decode_block(r.ahead + (r.block - r.aheadFirst) * blockAlign, blockAlign, r.samples);
+        if (r.block == blocks - 1) r.count = lastBlockSamples;
+        r.position = 0;
+        r.block++;
+        return true;
+    }
+
+public:
+    explicit AdpcmLoopPlayer(const char* path) : path(path) {}
+
+    // open the loop file, call from the control task; false when it is missing or not a usable ADPCM WAV
+    bool open() {
+        lock();
+        if (file) file.close();
+        file = SPIFFS.open(path, "r");
+        loaded = file && parse();
+        if (!loaded && file) file.close();
+        restart();
+        unlock();
+        return loaded;
+    }
+
+    void close() {
+        lock();
+        if (file) file.close();
+        loaded = false;
+        unlock();
+    }
+
+    bool isLoaded() const { return loaded; }
+
+    // loop length in seconds, 0 when nothing is loaded
+    float getSeconds() const {
+        return loaded ? static_cast<float>((blocks - 1) * adpcm_samples_per_block(blockAlign) + lastBlockSamples) / AUDIO_SAMPLE_RATE : 0.0f;
+    }
+
+    // store an uploaded file in chunks, index is the chunk's offset in the file.
+    // The loop is silent while the upload runs and is opened after the final chunk.
+    bool upload(size_t index, const uint8_t* data, size_t length, bool final) {
+        if (index == 0) {
+            close();
+            if (uploadFile) uploadFile.close();
+            SPIFFS.remove(path);
+            uploadFile = SPIFFS.open(path, "w");
+        }
+        if (!uploadFile) return false;
+        if (length && uploadFile.write(data, length) != length) { // partition full
+            uploadFile.close();
+            SPIFFS.remove(path);
+            return false;
+        }
+        if (!final) return true;
+        uploadFile.close();
+        return open();
+    }
+
+    // render path: back to the start of the loop
+    void reset() {
+        int expected = FREE;
+        if (!access.compare_exchange_strong(expected, RENDERING, std::memory_order_acquire)) return;
+        if (loaded) restart();
+        access.store(FREE, std::memory_order_release);
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount, bool stereo) {
+        int32_t i = 0;
+        int expected = FREE;
+        if (access.compare_exchange_strong(expected, RENDERING, std::memory_order_acquire)) {
+            while (i < frameCount && loaded) {
+                if (left.position == left.count && !nextBlock(left)) loaded = false;
+                if (stereo && right.position == right.count && !nextBlock(right)) loaded = false;
+                if (!loaded) break; // read error, stays silent until the next open
+                int32_t count = frameCount - i;
+                if (count > left.count - left.position) count = left.count - left.position;
+                if (stereo) {
+                    if (count > right.count - right.position) count = right.count - right.position;
+                    for (int32_t k = 0; k < count; k++) data[i + k] = Frame(left.samples[left.position + k], right.samples[right.position + k]);
+                    right.position += count;
+                } else {
+                    for (int32_t k = 0; k < count; k++) data[i + k] = Frame(left.samples[left.position + k]);
+                }
+                left.position += count;
+                i += count;
+            }
+            access.store(FREE, std::memory_order_release);
+        }
+        for (; i < frameCount; i++) data[i] = Frame(0);
+    }
+};
+
+AdpcmLoopPlayer adpcmLoop(ADPCM_LOOP_PATH);
+
+// registry entry points
+void render_adpcm_loop(Frame* data, int32_t frameCount, bool stereo) { adpcmLoop.renderBlock(data, frameCount, stereo); }
+
+void reset_adpcm_loop() { adpcmLoop.reset(); }
+
+#endif
@@ -2,19 +2,42 @@
 #define AUDIO_PLAYER_H
 
 #include <BluetoothA2DPSource.h>
+#include <atomic>
 #include <vector>
 #include <string>
 #include "pink_noise.h"
+#include "noise_registry.h"
+#include "audio_sink.h"
+#include "crossfade.h"
+#include "gain_stage.h"
+#include "equalizer.h"
+#include "render_stats.h"
 #include "config.h"
 
 class AudioPlayer {
 private:
     BluetoothA2DPSource* a2dp_source = nullptr;
     static int noiseAlgorithm;
-    static const int MaxNoiseAlg = 2;
     static bool isPlaying;
-    int btVolume = 50;
+    static bool stereo;
+    static int renderedAlgorithm;  // algorithm the render path is producing, follows noiseAlgorithm at block boundaries
+    static int fadingAlgorithm;    // algorithm being faded out while the crossfade is active
+    static Crossfade crossfade;
+    static Frame fadeBuffer[AUDIO_RENDER_FRAMES];
+    static GainStage gainStage;
+    static Equalizer equalizer;
+    static A2dpSink a2dpSink;
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S
+    static I2sSink i2sSink;
+#endif
+    static AudioSink* sink; // where the producer task renders to
+    static TaskHandle_t producerTask;
+    static RenderStats renderStats;
+    int fineVolume = 100 * VOLUME_FINE_STEPS; // the gain stage starts at unity
+    float noiseSlope = -3.0f;
     std::vector<std::string> *btDevices = nullptr;
+    std::string scanTarget; // the stored speaker, its discovery ends the scan early
+    std::atomic<bool> scanTargetSeen{false};
 
     static AudioPlayer* instance;
 
@@ -25,13 +48,55 @@ private:
                 Serial.print("Found device: ");
                 Serial.println(name);
             }
+            // no stored speaker must not match the devices that advertise no name
+            if (!instance->scanTarget.empty() && instance->scanTarget == name) instance->scanTargetSeen.store(true, std::memory_order_relaxed);
         }
         return false;
     }
 
+    // render up to maxFrames into the sink, returns the frames rendered, 0 when the sink is full
+    static int32_t renderToSink(AudioSink& out, int32_t maxFrames) {
+        int32_t count = maxFrames;
+        Frame* region = out.acquire(count);
+        if (count == 0) return 0;
+#if RENDER_STATS
+        uint32_t start = renderStats.begin();
+        renderFrames(region, count);
+        if (isPlaying) renderStats.addSynthesis(start, count); // muted blocks are counted as silent frames
+#else
+        renderFrames(region, count);
+#endif
+        out.commit(count);
+        return count;
+    }
+
+    // generator task: keeps the sink fed, for A2DP the ring so the callback only copies frames
+    static void producerLoop(void*) {
+        for (;;) {
+            if (!renderToSink(*sink, AUDIO_RENDER_FRAMES)) sink->wait(); // full, wait for it to drain
+        }
+    }
+
+    static void startProducer() {
+#if AUDIO_PRODUCER_TASK
+        if (!producerTask) {
+            xTaskCreatePinnedToCore(producerLoop, "noise", 4096, nullptr, AUDIO_PRODUCER_PRIORITY, &producerTask, AUDIO_PRODUCER_CORE);
+        }
+#endif
+    }
+
 public:
     AudioPlayer() {
         instance = this;
+        crossfade.setDuration(NOISE_CROSSFADE_MS, AUDIO_SAMPLE_RATE);
+        gainStage.setRampTime(GAIN_RAMP_MS, AUDIO_SAMPLE_RATE);
+        blueNoise.setProfile(NoiseProfile::slope(3.0f));
+        violetNoise.setProfile(NoiseProfile::slope(6.0f));
+        greyNoise.setProfile(NoiseProfile::grey());
+        customNoise.setProfile(NoiseProfile::slope(noiseSlope));
+        setLayer(0, find_noise_algorithm("Brown"), 0.8f);
+        setLayer(1, find_noise_algorithm("Pink filter v2"), 0.3f);
+        setLayer(2, find_noise_algorithm("Tone"), 0.0f);
         btDevices = new std::vector<std::string>();
     }
 
@@ -47,10 +112,20 @@ public:
     }
 
     void init(const char* btSpeaker) {
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S
+        // wired DAC instead of a speaker, the producer task is the whole pipeline
+        if (sink != &i2sSink) {
+            if (!i2sSink.begin()) Serial.println("I2S init failed");
+            sink = &i2sSink;
+        }
+        startProducer();
+        return;
+#endif
         if (!a2dp_source) {
           a2dp_source = new BluetoothA2DPSource();
         }
-        a2dp_source->set_volume(btVolume);
+        a2dp_source->set_volume(A2DP_VOLUME);
+        startProducer();
         a2dp_source->start(btSpeaker, get_sound_data);
     }
 
@@ -67,41 +142,56 @@ public:
         }
     }
 
-    void startScan() {
-        Serial.println("AudioPlayer startScan");
+    // first step of a scan: drop the speaker connection. The caller lets the
+    // disconnect settle, without blocking, before it calls startScan.
+    void prepareScan() {
+        Serial.println("AudioPlayer prepareScan");
         btDevices->clear();
+        scanTargetSeen.store(false, std::memory_order_relaxed);
         if (a2dp_source == nullptr) {
             a2dp_source = new BluetoothA2DPSource();
         }
         a2dp_source->set_connected(false);
         Serial.println("AudioPlayer disconnect()");
-        for(int i = 0; i<20; i++) {
-          digitalWrite(LED_PIN, i % 2);
-          delay(500);
-        }
+    }
 
+    // start the inquiry, returns at once; devices are added by the callback as they are found
+    void startScan(const char* storedSpeaker) {
+        Serial.println("AudioPlayer startScan");
+        scanTarget = storedSpeaker ? storedSpeaker : "";
         a2dp_source->set_ssid_callback(scan_callback);
         a2dp_source->set_auto_reconnect(false);
+        startProducer();
         a2dp_source->set_data_callback_in_frames(get_sound_data);
         a2dp_source->set_valid_cod_service(ESP_BT_COD_SRVC_AUDIO);
         a2dp_source->start();
         Serial.println("AudioPlayer start()");
     }
 
+    // whether the scan has found the stored speaker
+    bool scanFoundStored() const { return scanTargetSeen.load(std::memory_order_relaxed); }
+
     const std::vector<std::string>* getDevices() const {
         return btDevices;
     }
 
     void setVolume(int volume) {
-        btVolume = volume;
-        if(btVolume > 100) btVolume = 100;
-        if(btVolume < 0) btVolume = 0;
-        if (a2dp_source) {
-            a2dp_source->set_volume(btVolume);
-        }
+        setFineVolume(volume * VOLUME_FINE_STEPS);
     }
 
-    int getVolume() { return btVolume; }
+    int getVolume() { return fineVolume / VOLUME_FINE_STEPS; }
+
+    // volume in 0..100 * VOLUME_FINE_STEPS. The A2DP volume stays at A2DP_VOLUME,
+    // so the speaker keeps its analog headroom and never jumps by its own step
+    // size; every step is a software attenuation the gain stage ramps to.
+    void setFineVolume(int volume) {
+        fineVolume = volume;
+        if(fineVolume > 100 * VOLUME_FINE_STEPS) fineVolume = 100 * VOLUME_FINE_STEPS;
+        if(fineVolume < 0) fineVolume = 0;
+        gainStage.setAttenuation(volume_attenuation(fineVolume));
+    }
+
+    int getFineVolume() { return fineVolume; }
     
     void togglePlay() {
         isPlaying = !isPlaying;
@@ -111,48 +201,178 @@ public:
 
     void nextAlgorithm() {
         noiseAlgorithm++;
-        if(noiseAlgorithm > MaxNoiseAlg) noiseAlgorithm = 0;
+        if(noiseAlgorithm >= NOISE_ALGORITHM_COUNT) noiseAlgorithm = 0;
     }
 
     int getCurrentAlgorithm() { return noiseAlgorithm; }
 
+    void setAlgorithm(int algorithm) {
+        if (algorithm >= 0 && algorithm < NOISE_ALGORITHM_COUNT) noiseAlgorithm = algorithm;
+    }
+
+    const char* getAlgorithmName() { return noiseAlgorithms[noiseAlgorithm].name; }
+
+    // stereo renders independent noise on each channel, mono duplicates one channel
+    void setStereo(bool enabled) { stereo = enabled; }
+
+    bool getStereo() { return stereo; }
+
+    // slope of the custom colored noise algorithm in dB per octave, redesigned only when it changes
+    void setNoiseSlope(float dbPerOctave) {
+        if (dbPerOctave > 12.0f) dbPerOctave = 12.0f;
+        if (dbPerOctave < -12.0f) dbPerOctave = -12.0f;
+        if (dbPerOctave == noiseSlope) return;
+        noiseSlope = dbPerOctave;
+        customNoise.setProfile(NoiseProfile::slope(noiseSlope));
+    }
+
+    float getNoiseSlope() { return noiseSlope; }
+
+    // tone algorithm: carrier and beat in Hz, mode ToneGenerator::BINAURAL or ISOCHRONIC
+    void setTone(float carrierHz, float beatHz, int mode) { toneGenerator.setTone(carrierHz, beatHz, mode); }
+
+    float getToneCarrier() { return toneGenerator.getCarrier(); }
+
+    float getToneBeat() { return toneGenerator.getBeat(); }
+
+    int getToneMode() { return toneGenerator.getMode(); }
+
+    // soundscape layer: a registry index (-1 empties the layer) and a linear gain
+    void setLayer(int layer, int algorithm, float gain) {
+        const NoiseAlgorithm* source = algorithm >= 0 && algorithm < NOISE_ALGORITHM_COUNT ? &noiseAlgorithms[algorithm] : nullptr;
+        noiseMixer.setLayer(layer, source, gain);
+    }
+
+    int getLayerAlgorithm(int layer) {
+        const NoiseAlgorithm* source = noiseMixer.getLayerSource(layer);
+        return source ? static_cast<int>(source - noiseAlgorithms) : -1;
+    }
+
+    float getLayerGain(int layer) { return noiseMixer.getLayerGain(layer); }
+
+    // output EQ band, see EqBand for the limits
+    void setEqBand(int band, const EqBand& settings) { equalizer.setBand(band, settings); }
+
+    const EqBand& getEqBand(int band) { return equalizer.getBand(band); }
+
+    // length of the crossfade applied when the algorithm changes
+    void setCrossfadeDuration(uint32_t milliseconds) { crossfade.setDuration(milliseconds, AUDIO_SAMPLE_RATE); }
+
+    uint32_t getUnderruns() { return a2dpSink.getUnderruns(); }
+
+    RenderStats& getRenderStats() { return renderStats; }
+
+    // A2DP callback, runs in the Bluetooth stack's context
     static int32_t get_sound_data(Frame* data, int32_t frameCount) {
+#if RENDER_STATS
+        uint32_t start = renderStats.begin();
+#endif
+#if AUDIO_PRODUCER_TASK
+        a2dpSink.read(data, frameCount); // pads with silence on underrun
+        if (producerTask) xTaskNotifyGive(producerTask);
+#else
+        renderFrames(data, frameCount);
+#if RENDER_STATS
+        if (isPlaying) renderStats.addSynthesis(start, frameCount);
+#endif
+#endif
+#if RENDER_STATS
+        renderStats.end(start, frameCount);
+#endif
+        return frameCount;
+    }
+
+    // render frameCount frames through the whole pipeline into a sink, as fast as it takes them.
+    // For offline rendering, e.g. into a FileSink; the sink must have been begun.
+    static void renderTo(AudioSink& out, uint64_t frameCount) {
+        while (frameCount > 0) {
+            int32_t count = renderToSink(out, frameCount < AUDIO_RENDER_FRAMES ? static_cast<int32_t>(frameCount) : AUDIO_RENDER_FRAMES);
+            if (count == 0) out.wait();
+            frameCount -= count;
+        }
+    }
+
+    // during a crossfade between the soundscape mixer and one of its layers: that layer, whose generator both sides play
+    static const NoiseAlgorithm* sharedLayer() {
+        const NoiseAlgorithm& from = noiseAlgorithms[fadingAlgorithm];
+        const NoiseAlgorithm& to = noiseAlgorithms[renderedAlgorithm];
+        if (from.render == render_mixer && noiseMixer.hasLayer(&to)) return &to;
+        if (to.render == render_mixer && noiseMixer.hasLayer(&from)) return &from;
+        return nullptr;
+    }
+
+    // render one algorithm, the generator is selected once for the whole block
+    static void renderAlgorithm(int algorithm, Frame* data, int32_t frameCount) {
+        noiseAlgorithms[algorithm].render(data, frameCount, stereo);
+    }
+
+    // synthesize frames for the selected algorithm
+    static int32_t renderFrames(Frame* data, int32_t frameCount) {
+        noiseMixer.update(); // soundscape layers set since the last block
         if (!isPlaying) {
             for (int i = 0; i < frameCount; i++) {
                 data[i].channel1 = 0;
                 data[i].channel2 = 0;
             }
+#if RENDER_STATS
+            renderStats.addSilentFrames(frameCount);
+#endif
             return frameCount;
         }
         
-        for (int i = 0; i < frameCount; i++) {
-            float sample;
-            switch(noiseAlgorithm) {
-                case 0: { 
-                    float pinkNoise = pinkNoiseFilterV2.generateSample();
-                    sample = pinkNoise;
-                }
-                break;
-                case 1: {
-                    float brownNoise = brownNoiseGenerator.generateSample();
-                    sample = brownNoise;
-                }
-                break;
-                default: { // cursor
-                    sample = generate_pink_noise() * 0.5;
-                }
+        // algorithm changes take effect at block boundaries and are crossfaded,
+        // a change requested during a fade waits until the fade has finished
+        int target = noiseAlgorithm;
+        if (target != renderedAlgorithm && !crossfade.isActive()) {
+            fadingAlgorithm = renderedAlgorithm;
+            renderedAlgorithm = target;
+            // start from a clean state, not from where it was left, unless the generator is playing in the outgoing mix
+            const NoiseAlgorithm* shared = sharedLayer();
+            if (!shared) noiseAlgorithms[target].reset();
+            else if (shared != &noiseAlgorithms[target]) noiseMixer.reset(shared);
+            crossfade.start();
+        }
+
+        int32_t offset = 0;
+        while (offset < frameCount && crossfade.isActive()) {
+            int32_t count = frameCount - offset < AUDIO_RENDER_FRAMES ? frameCount - offset : AUDIO_RENDER_FRAMES;
+            const NoiseAlgorithm* shared = sharedLayer();
+            if (!shared) {
+                renderAlgorithm(renderedAlgorithm, data + offset, count);
+                renderAlgorithm(fadingAlgorithm, fadeBuffer, count);
+            } else if (shared == &noiseAlgorithms[renderedAlgorithm]) { // mix fading into one of its layers
+                renderAlgorithm(renderedAlgorithm, data + offset, count);
+                noiseMixer.render(fadeBuffer, count, stereo, shared, data + offset);
+            } else { // a layer fading into the mix
+                renderAlgorithm(fadingAlgorithm, fadeBuffer, count);
+                noiseMixer.render(data + offset, count, stereo, shared, fadeBuffer);
             }
-            
-            // convert float to 16-bit integer
-            int16_t pcm = static_cast<int16_t>(sample * 32767);
-            data[i] = Frame(pcm);
+            crossfade.mix(fadeBuffer, data + offset, count);
+            offset += count;
         }
+        if (offset < frameCount) renderAlgorithm(renderedAlgorithm, data + offset, frameCount - offset);
+        equalizer.process(data, frameCount);
+        gainStage.process(data, frameCount);
         return frameCount;
     }
 };
 
 AudioPlayer* AudioPlayer::instance = nullptr;
 int AudioPlayer::noiseAlgorithm = 1;
+int AudioPlayer::renderedAlgorithm = 1;
+int AudioPlayer::fadingAlgorithm = 1;
 bool AudioPlayer::isPlaying = true;
+bool AudioPlayer::stereo = false;
+A2dpSink AudioPlayer::a2dpSink;
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S
+I2sSink AudioPlayer::i2sSink;
+#endif
+AudioSink* AudioPlayer::sink = &AudioPlayer::a2dpSink;
+TaskHandle_t AudioPlayer::producerTask = nullptr;
+Crossfade AudioPlayer::crossfade;
+Frame AudioPlayer::fadeBuffer[AUDIO_RENDER_FRAMES];
+GainStage AudioPlayer::gainStage;
+Equalizer AudioPlayer::equalizer;
+RenderStats AudioPlayer::renderStats;
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,136 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <stdio.h>
+#include <Arduino.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "pcm_ring_buffer.h"
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S
+#include <ESP_I2S.h>
+#endif
+
+// destination of rendered audio. The render pipeline asks for a region, renders
+// into it and commits it, so a sink with a buffer of its own (a ring, a DMA
+// queue) is filled without an extra copy.
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+
+    virtual bool begin() { return true; }
+
+    virtual void end() {}
+
+    // space for at most count frames, count is reduced to what fits and is 0 when the sink is full
+    virtual Frame* acquire(int32_t& count) = 0;
+
+    // output the first count frames of the acquired region
+    virtual void commit(int32_t count) = 0;
+
+    // block until there may be space again, after acquire returned none
+    virtual void wait() {}
+};
+
+// Bluetooth speaker: frames go into a ring that the A2DP callback drains, the
+// callback notifies the producer task after every read
+class A2dpSink : public AudioSink {
+private:
+    PcmRingBuffer<AUDIO_RING_FRAMES> ring;
+
+public:
+    Frame* acquire(int32_t& count) override { return ring.writeRegion(count); }
+
+    void commit(int32_t count) override { ring.commit(count); }
+
+    void wait() override { ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20)); }
+
+    // A2DP callback side, pads with silence on underrun
+    int32_t read(Frame* data, int32_t count) { return ring.read(data, count); }
+
+    uint32_t getUnderruns() const { return ring.getUnderruns(); }
+};
+
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S
+// wired I2S DAC (PCM5102, MAX98357A, ...), 16-bit stereo at AUDIO_SAMPLE_RATE.
+// Writes block until the DMA queue has room, so the producer task is paced by the DAC clock.
+class I2sSink : public AudioSink {
+private:
+    I2SClass i2s;
+    Frame buffer[AUDIO_RENDER_FRAMES];
+
+public:
+    bool begin() override {
+        i2s.setPins(I2S_BCLK_PIN, I2S_LRCK_PIN, I2S_DOUT_PIN);
+        return i2s.begin(I2S_MODE_STD, AUDIO_SAMPLE_RATE, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO);
+    }
+
+    void end() override { i2s.end(); }
+
+    Frame* acquire(int32_t& count) override {
+        if (count > AUDIO_RENDER_FRAMES) count = AUDIO_RENDER_FRAMES;
+        return buffer;
+    }
+
+    void commit(int32_t count) override { i2s.write(reinterpret_cast<const uint8_t*>(buffer), count * sizeof(Frame)); }
+};
+#endif
+
+// 16-bit stereo WAV or raw PCM file, takes frames as fast as they are rendered.
+// Frames are written as they are in memory, which is the WAV byte order on the
+// ESP32 and on x86/ARM hosts. The WAV sizes are patched in by end() when the
+// file is seekable, a pipe keeps the open-ended placeholder.
+class FileSink : public AudioSink {
+private:
+    const char* path;
+    bool wav;
+    FILE* file = nullptr;
+    uint32_t frames = 0;
+    Frame buffer[AUDIO_RENDER_FRAMES];
+
+    void writeHeader(uint32_t dataBytes) {
+        uint8_t h[44];
+        const uint32_t values[] = {36 + dataBytes, 16, 0x00020001u, AUDIO_SAMPLE_RATE, AUDIO_SAMPLE_RATE * 4, 0x00100004u, dataBytes};
+        memcpy(h, "RIFF", 4);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        memcpy(h + 36, "data", 4);
+        const int offsets[] = {4, 16, 20, 24, 28, 32, 40}; // format 1 with 2 channels, block 4 with 16 bits
+        for (int i = 0; i < 7; i++) {
+            for (int k = 0; k < 4; k++) h[offsets[i] + k] = (values[i] >> (8 * k)) & 0xFF;
+        }
+        fwrite(h, 1, sizeof(h), file);
+    }
+
+public:
+    // path "-" writes to stdout
+    FileSink(const char* path, bool wav) : path(path), wav(wav) {}
+
+    bool begin() override {
+        file = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+        if (!file) return false;
+        frames = 0;
+        if (wav) writeHeader(0xFFFFFFFFu - 36);
+        return true;
+    }
+
+    void end() override {
+        if (!file) return;
+        if (wav && file != stdout && fseek(file, 0, SEEK_SET) == 0) writeHeader(frames * sizeof(Frame));
+        if (file != stdout) fclose(file);
+        else fflush(file);
+        file = nullptr;
+    }
+
+    Frame* acquire(int32_t& count) override {
+        if (count > AUDIO_RENDER_FRAMES) count = AUDIO_RENDER_FRAMES;
+        return buffer;
+    }
+
+    void commit(int32_t count) override {
+        fwrite(buffer, sizeof(Frame), count, file);
+        frames += count;
+    }
+
+    uint32_t getFrames() const { return frames; }
+};
+
+#endif
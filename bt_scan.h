@@ -0,0 +1,62 @@
+#ifndef BT_SCAN_H
+#define BT_SCAN_H
+
+#include <Arduino.h>
+#include <string>
+#include "audio_player.h"
+
+// Bluetooth speaker scan, stepped from loop() with the current millis() so
+// nothing blocks: drop the connection, let it settle, run the inquiry until
+// the timeout or until the stored speaker has been seen for a while.
+class BtScan {
+public:
+    static const unsigned long SETTLE_TIME = 1000;  // disconnect to inquiry start
+    static const unsigned long TIMEOUT = 15000;     // inquiry length without the stored speaker
+    static const unsigned long LINGER_TIME = 3000;  // keep scanning this long after the stored speaker is seen, for the ones near it
+
+    explicit BtScan(AudioPlayer& player) : player(player) {}
+
+    void start(unsigned long now, const char* storedSpeaker) {
+        player.prepareScan();
+        target = storedSpeaker ? storedSpeaker : "";
+        startTime = now;
+        inquiry = false;
+        foundStored = false;
+    }
+
+    // one step, returns true when the scan is over and the player stopped
+    bool update(unsigned long now) {
+        if (!inquiry) {
+            if (now - startTime < SETTLE_TIME) return false;
+            player.startScan(target.c_str());
+            startTime = now;
+            inquiry = true;
+            return false;
+        }
+        if (!foundStored && player.scanFoundStored()) {
+            Serial.println("Stored speaker found");
+            foundStored = true;
+            foundTime = now;
+        }
+        if (now - startTime >= TIMEOUT || (foundStored && now - foundTime >= LINGER_TIME)) {
+            Serial.print("Found devices: ");
+            Serial.println(player.getDevices()->size());
+            player.stop();
+            return true;
+        }
+        return false;
+    }
+
+    // LED blink phase while scanning
+    int led(unsigned long now) const { return ((now - startTime) / 500) % 2; }
+
+private:
+    AudioPlayer& player;
+    std::string target;
+    unsigned long startTime = 0;
+    unsigned long foundTime = 0; // when the stored speaker was seen
+    bool inquiry = false;
+    bool foundStored = false;
+};
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef COLORED_NOISE_H
+#define COLORED_NOISE_H
+
+#include <math.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "noise_random.h"
+#include "pcm_convert.h"
+#include "triple_buffer.h"
+
+// spectral magnitude profile: level in dB at octave centres 31.25 Hz * 2^k,
+// the spectrum is held flat below the first and above the last centre
+struct NoiseProfile {
+    static const int BANDS = 10; // 31.25 Hz .. 16 kHz
+    float bandDb[BANDS];
+
+    // constant slope in dB per octave: -3 pink, -6 brown, +3 blue, +6 violet
+    static NoiseProfile slope(float dbPerOctave) {
+        NoiseProfile profile;
+        for (int k = 0; k < BANDS; k++) profile.bandDb[k] = dbPerOctave * k;
+        return profile;
+    }
+
+    // grey: inverse A-weighting, the bass boost is capped at +20 dB
+    static NoiseProfile grey() {
+        static const float aWeighting[BANDS] = {-39.4f, -26.2f, -16.1f, -8.6f, -3.2f, 0.0f, 1.2f, 1.0f, -1.1f, -6.6f};
+        NoiseProfile profile;
+        for (int k = 0; k < BANDS; k++) profile.bandDb[k] = fminf(-aWeighting[k], 20.0f);
+        return profile;
+    }
+};
+
+// coefficients of a cascade of first-order sections, y = b0 x + s; s = b1 x - a1 y
+struct ColoredNoiseDesign {
+    static const int MAX_SECTIONS = COLORED_NOISE_MAX_SECTIONS;
+    int sections = 0;
+    float b0[MAX_SECTIONS];
+    float b1[MAX_SECTIONS];
+    float a1[MAX_SECTIONS];
+    int slot[MAX_SECTIONS]; // octave * 2 + position in it, keeps a section's filter state across redesigns
+    float gain = 1.0f;
+};
+
+// colored noise engine: white noise through a designed IIR cascade. Each octave
+// between two profile points is approximated by interleaved pole/zero pairs
+// (a section drops or rises 6 dB/octave between its pole and zero), so any
+// slope up to +/-12 dB/octave and any piecewise profile can be followed.
+// Coefficients are designed only when the profile changes, outside the audio
+// path, and handed to the render path through a triple buffer that it picks
+// up at block start, so quick changes in a row never tear the design in use.
+// Filter states are kept across redesigns and the output gain ramps to the new
+// design's over one block, so moving the profile does not click.
+class ColoredNoiseGenerator {
+private:
+    TripleBuffer<ColoredNoiseDesign> designs;
+    float states[ColoredNoiseDesign::MAX_SECTIONS] = {0};
+    int stateSlots[ColoredNoiseDesign::MAX_SECTIONS]; // slot of the section each state was filtered by
+    float gain = 0.0f; // output gain at the end of the last block, ramps to a new design's over one block
+    NoiseRandom rng;
+
+    static void addSection(ColoredNoiseDesign& design, int slot, float poleHz, float zeroHz, float sampleRate) {
+        if (design.sections >= ColoredNoiseDesign::MAX_SECTIONS) return;
+        const float limit = 0.45f * sampleRate;
+        poleHz = fminf(poleHz, limit);
+        zeroHz = fminf(zeroHz, limit);
+        // bilinear transform of (s + wz) / (s + wp) with pre-warped corners
+        const float k = 2.0f * sampleRate;
+        const float wp = k * tanf(3.14159265f * poleHz / sampleRate);
+        const float wz = k * tanf(3.14159265f * zeroHz / sampleRate);
+        const int n = design.sections++;
+        design.slot[n] = slot;
+        design.b0[n] = (k + wz) / (k + wp);
+        design.b1[n] = (wz - k) / (k + wp);
+        design.a1[n] = (wp - k) / (k + wp);
+    }
+
+    // power gain for white noise, |H|^2 averaged over linearly spaced frequencies
+    static float whiteNoiseGain(const ColoredNoiseDesign& design) {
+        const int POINTS = 256;
+        float sum = 0.0f;
+        for (int p = 0; p < POINTS; p++) {
+            float w = 3.14159265f * (p + 0.5f) / POINTS;
+            float c = cosf(w), s = sinf(w);
+            float power = 1.0f;
+            for (int n = 0; n < design.sections; n++) {
+                // |b0 + b1 e^-jw|^2 / |1 + a1 e^-jw|^2
+                float nr = design.b0[n] + design.b1[n] * c, ni = -design.b1[n] * s;
+                float dr = 1.0f + design.a1[n] * c, di = -design.a1[n] * s;
+                power *= (nr * nr + ni * ni) / (dr * dr + di * di);
+            }
+            sum += power;
+        }
+        return sum / POINTS;
+    }
+
+    // move the states to the sections of a new design with the same slot, new sections start from zero
+    void remapStates(const ColoredNoiseDesign& design, const int* oldSlots) {
+        float old[ColoredNoiseDesign::MAX_SECTIONS];
+        for (int n = 0; n < ColoredNoiseDesign::MAX_SECTIONS; n++) {
+            old[n] = states[n];
+            states[n] = 0.0f;
+        }
+        for (int n = 0; n < design.sections; n++) {
+            for (int m = 0; m < ColoredNoiseDesign::MAX_SECTIONS; m++) {
+                if (oldSlots[m] == design.slot[n]) states[n] = old[m];
+            }
+        }
+    }
+
+    // design to render with, the states follow their sections when a new one has been published
+    const ColoredNoiseDesign& beginBlock(ColoredNoiseGenerator* right) {
+        if (designs.update()) {
+            const ColoredNoiseDesign& design = designs.read();
+            remapStates(design, stateSlots);
+            if (right) right->remapStates(design, stateSlots);
+            for (int n = 0; n < ColoredNoiseDesign::MAX_SECTIONS; n++) stateSlots[n] = n < design.sections ? design.slot[n] : -1;
+        }
+        return designs.read();
+    }
+
+public:
+    ColoredNoiseGenerator() {
+        for (int n = 0; n < ColoredNoiseDesign::MAX_SECTIONS; n++) stateSlots[n] = -1;
+    }
+
+    NoiseRandom& random() { return rng; }
+
+    // clear the filter states, call from the render path only
+    void reset() {
+        for (int n = 0; n < ColoredNoiseDesign::MAX_SECTIONS; n++) states[n] = 0.0f;
+    }
+
+    // design the cascade for a profile, call from the control task, never from the audio path
+    void setProfile(const NoiseProfile& profile, float sampleRate = AUDIO_SAMPLE_RATE) {
+        ColoredNoiseDesign& design = designs.writeBuffer();
+        design.sections = 0;
+        for (int k = 0; k + 1 < NoiseProfile::BANDS; k++) {
+            float slope = profile.bandDb[k + 1] - profile.bandDb[k];
+            if (slope > 12.0f) slope = 12.0f;
+            if (slope < -12.0f) slope = -12.0f;
+            int count = static_cast<int>(ceilf(fabsf(slope) / 6.0f - 0.01f));
+            float baseHz = 31.25f * (1 << k);
+            for (int j = 0; j < count; j++) {
+                float cornerHz = baseHz * exp2f(static_cast<float>(j) / count);
+                float spread = exp2f(fabsf(slope) / count / 6.02f);
+                if (slope < 0) addSection(design, k * 2 + j, cornerHz, cornerHz * spread, sampleRate);
+                else addSection(design, k * 2 + j, cornerHz * spread, cornerHz, sampleRate);
+            }
+        }
+        design.gain = COLORED_NOISE_RMS / (0.57735f * sqrtf(whiteNoiseGain(design))); // white input rms is 1/sqrt(3)
+        designs.publish();
+    }
+
+    // render a block of float samples
+    void renderBlock(float* out, int32_t frameCount) {
+        const ColoredNoiseDesign& design = beginBlock(nullptr);
+        const int sections = design.sections;
+        if (gain == 0.0f) gain = design.gain;
+        const float step = (design.gain - gain) / frameCount;
+        float g = gain;
+        for (int32_t i = 0; i < frameCount; i++) {
+            float x = rng.nextFloat();
+            for (int n = 0; n < sections; n++) {
+                float y = design.b0[n] * x + states[n];
+                states[n] = design.b1[n] * x - design.a1[n] * y;
+                x = y;
+            }
+            g += step;
+            out[i] = x * g;
+        }
+        gain = design.gain;
+    }
+
+    // stereo version, both channels follow this generator's design and are filtered in the same pass
+    void renderBlock(float* left, float* rightOut, int32_t frameCount, ColoredNoiseGenerator& right) {
+        const ColoredNoiseDesign& design = beginBlock(&right);
+        const int sections = design.sections;
+        if (gain == 0.0f) gain = design.gain;
+        const float step = (design.gain - gain) / frameCount;
+        float g = gain;
+        for (int32_t i = 0; i < frameCount; i++) {
+            float l = rng.nextFloat();
+            float r = right.rng.nextFloat();
+            for (int n = 0; n < sections; n++) {
+                float yl = design.b0[n] * l + states[n];
+                float yr = design.b0[n] * r + right.states[n];
+                states[n] = design.b1[n] * l - design.a1[n] * yl;
+                right.states[n] = design.b1[n] * r - design.a1[n] * yr;
+                l = yl;
+                r = yr;
+            }
+            g += step;
+            left[i] = l * g;
+            rightOut[i] = r * g;
+        }
+        gain = design.gain;
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) { render_pcm(*this, data, frameCount); }
+
+    void renderBlock(Frame* data, int32_t frameCount, ColoredNoiseGenerator& right) { render_pcm(*this, right, data, frameCount); }
+};
+
+// profiles are designed on the left/mono instance, *Right instances only hold the right channel's state
+ColoredNoiseGenerator blueNoise;
+ColoredNoiseGenerator blueNoiseRight;
+ColoredNoiseGenerator violetNoise;
+ColoredNoiseGenerator violetNoiseRight;
+ColoredNoiseGenerator greyNoise;
+ColoredNoiseGenerator greyNoiseRight;
+ColoredNoiseGenerator customNoise;
+ColoredNoiseGenerator customNoiseRight;
+
+#endif
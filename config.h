@@ -13,5 +13,56 @@ const int LED_PIN = 18;
 #define TOUCH_THRESHOLD 40 // Touch threshold
 #define TOUCH_FILTER 10 // 10ms debounce filter
 
+#define NOISE_RANDOM_ENGINE XorShift32 // white noise engine: XorShift32 or Pcg32
+#define NOISE_FIXED_POINT 0 // 1 = integer (Q15/Q31) generators, no FPU use in the audio callback
+#define NOISE_FIXED_SEED 0 // non-zero seeds all generators with a fixed value for reproducible output
+
+#define AUDIO_SAMPLE_RATE 44100 // A2DP stream rate
+#define PCM_DITHER 0 // 1 = add TPDF dither when converting float samples to 16-bit PCM
+#define PCM_CHUNK_FRAMES 64 // float scratch block used by the PCM conversion, on the stack
+#define COLORED_NOISE_MAX_SECTIONS 20 // first-order sections in the colored noise cascade
+#define COLORED_NOISE_RMS 0.2f // output level of the colored noise engine
+#define NOISE_LOOP 0 // 1 = add a flash loop algorithm playing noise_loop.cpp, generate it with "make -C tools ../noise_loop.cpp"
+#define ADPCM_LOOP 1 // 1 = add an algorithm playing an IMA-ADPCM loop uploaded to SPIFFS through the web interface
+#define ADPCM_LOOP_PATH "/loop.wav"
+#define ADPCM_MAX_BLOCK_ALIGN 512 // largest ADPCM block accepted, sets the decode buffer size
+#define ADPCM_READ_AHEAD_BLOCKS 4 // ADPCM blocks read from flash at a time, per channel
+#define NOISE_CROSSFADE_MS 500 // equal-power crossfade when switching algorithms
+#define MIXER_LAYERS 4 // sounds the soundscape mixer can layer
+#define TONE_CARRIER_HZ 200 // default tone carrier
+#define TONE_BEAT_HZ 10 // default binaural beat (difference between the ears) or isochronic pulse rate
+#define TONE_MIN_EAR_HZ 10 // the beat is limited so the lower ear never plays below this
+#define TONE_MODE 0 // default tone mode: 0 = binaural, 1 = isochronic
+#define TONE_LEVEL 0.2f // peak level of the tone generator
+#define TONE_CONTROL_FRAMES 32 // frames between tone envelope updates
+#define MODULATION_CONTROL_FRAMES 32 // frames between updates of the soundscape modulators
+
+#define VOLUME_FINE_STEPS 4 // software gain sub-steps per volume unit (0..100)
+#define VOLUME_RANGE_DB 50.0 // software attenuation from full volume down to the lowest step, linear in dB; 0 mutes
+#define A2DP_VOLUME 100 // fixed A2DP volume, the software gain sets the level below it; lower it if the speaker distorts at full volume
+#define GAIN_TABLE_STEP_DB 0.125 // resolution of the software gain table
+#define GAIN_TABLE_SIZE 481 // 0 to -60 dB
+#define GAIN_RAMP_MS 50 // time for the software gain to ramp from unity to silence
+#define EQ_BANDS 4 // output equalizer bands, each a biquad when enabled
+
+#define AUDIO_OUTPUT_A2DP 0
+#define AUDIO_OUTPUT_I2S 1
+#define AUDIO_OUTPUT AUDIO_OUTPUT_A2DP // AUDIO_OUTPUT_I2S plays on a wired I2S DAC instead of a Bluetooth speaker
+#define I2S_BCLK_PIN 26 // I2S DAC wiring
+#define I2S_LRCK_PIN 25
+#define I2S_DOUT_PIN 22
+#define AUDIO_PRODUCER_TASK 1 // 1 = synthesize in a dedicated task, the A2DP callback only copies from a ring buffer
+#define AUDIO_RING_FRAMES 2048 // ring buffer depth, power of two (2048 frames = 46 ms latency at 44.1 kHz)
+#define AUDIO_RENDER_FRAMES 256 // frames the producer task renders per pass
+#define AUDIO_PRODUCER_CORE 1 // the Bluetooth stack runs on core 0
+#define AUDIO_PRODUCER_PRIORITY 5 // above the Arduino loop task
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S && !AUDIO_PRODUCER_TASK
+#error "the I2S output is fed by the producer task, set AUDIO_PRODUCER_TASK to 1"
+#endif
+
+#define RENDER_STATS 1 // 1 = time every A2DP callback, reported on serial and at /api/stats
+#define RENDER_STATS_REPORT_MS 10000 // stats window while playing: reported, then the counters restart so they never wrap
+#define RENDER_STATS_SERIAL 1 // 1 = print each window on serial
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef CONSTEXPR_MATH_H
+#define CONSTEXPR_MATH_H
+
+// compile-time math for coefficient design, so generated tables and filter
+// constants cost nothing at runtime
+
+// compile-time exp, the argument is halved until the series converges quickly and squared back
+constexpr double constexpr_exp(double x) {
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) {
+        x /= 2;
+        halvings++;
+    }
+    double sum = 1.0, term = 1.0;
+    for (int n = 1; n < 16; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    while (halvings-- > 0) sum *= sum;
+    return sum;
+}
+
+// compile-time square root by Newton's method, x must not be negative
+constexpr double constexpr_sqrt(double x) {
+    if (x <= 0) return 0;
+    double r = x > 1 ? x : 1;
+    for (int n = 0; n < 64; n++) r = 0.5 * (r + x / r);
+    return r;
+}
+
+// compile-time sine, reduced to [-pi, pi] and summed as a Taylor series
+constexpr double constexpr_sin(double x) {
+    const double pi = 3.141592653589793;
+    while (x > pi) x -= 2 * pi;
+    while (x < -pi) x += 2 * pi;
+    double sum = x, term = x;
+    for (int n = 1; n < 14; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// pole of a one-pole lowpass with the given corner, matched-z: exp(-2 pi fc / fs)
+constexpr double one_pole(double cornerHz, double sampleRate) {
+    return constexpr_exp(-6.283185307179586 * cornerHz / sampleRate);
+}
+
+#endif
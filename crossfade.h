@@ -0,0 +1,66 @@
+#ifndef CROSSFADE_H
+#define CROSSFADE_H
+
+#include <math.h>
+#include <BluetoothA2DPSource.h>
+#include "pcm_convert.h"
+
+// equal-power crossfade between two blocks of frames. The gain curve is a
+// quarter sine sampled once into a Q15 table; per frame the table is read with
+// a fixed-point phase and linear interpolation, so no transcendental math runs
+// in the audio path.
+class Crossfade {
+private:
+    static const int TABLE_SIZE = 64;
+    int32_t gainTable[TABLE_SIZE + 2]; // sin(pi/2 * i / TABLE_SIZE) in Q15, last entry pads the interpolation
+    uint32_t fadeFrames = 1;
+    uint32_t phaseStep = TABLE_SIZE << 16; // table index per frame in Q16, defaults to an instant switch
+    uint32_t phase = 0;                // position in the table in Q16
+    bool active = false;
+
+    int32_t gainAt(uint32_t tablePhase) const {
+        uint32_t index = tablePhase >> 16;
+        int32_t frac = static_cast<int32_t>((tablePhase & 0xFFFF) >> 1); // Q15
+        int32_t a = gainTable[index];
+        return a + (((gainTable[index + 1] - a) * frac) >> 15);
+    }
+
+public:
+    Crossfade() {
+        for (int i = 0; i <= TABLE_SIZE; i++) {
+            gainTable[i] = static_cast<int32_t>(lroundf(32767.0f * sinf(1.57079632f * i / TABLE_SIZE)));
+        }
+        gainTable[TABLE_SIZE + 1] = gainTable[TABLE_SIZE];
+    }
+
+    void setDuration(uint32_t milliseconds, uint32_t sampleRate) {
+        fadeFrames = static_cast<uint32_t>(static_cast<uint64_t>(sampleRate) * milliseconds / 1000);
+        if (fadeFrames < 1) fadeFrames = 1;
+        phaseStep = static_cast<uint32_t>((static_cast<uint64_t>(TABLE_SIZE) << 16) / fadeFrames);
+        if (phaseStep < 1) phaseStep = 1; // fades longer than ~95 s at 44.1 kHz end early instead of never
+    }
+
+    void start() {
+        phase = 0;
+        active = true;
+    }
+
+    bool isActive() const { return active; }
+
+    // mix "from" fading out into "to" fading in, the result is written to "to"
+    void mix(const Frame* from, Frame* to, int32_t frameCount) {
+        const uint32_t end = static_cast<uint32_t>(TABLE_SIZE) << 16;
+        uint32_t remaining = (end - phase + phaseStep - 1) / phaseStep;
+        int32_t count = remaining < static_cast<uint32_t>(frameCount) ? static_cast<int32_t>(remaining) : frameCount;
+        for (int32_t i = 0; i < count; i++) {
+            int32_t gainIn = gainAt(phase);
+            int32_t gainOut = gainAt(end - phase);
+            to[i].channel1 = saturate_pcm((to[i].channel1 * gainIn + from[i].channel1 * gainOut) >> 15);
+            to[i].channel2 = saturate_pcm((to[i].channel2 * gainIn + from[i].channel2 * gainOut) >> 15);
+            phase += phaseStep;
+        }
+        if (phase >= end) active = false;
+    }
+};
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include <math.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "pcm_convert.h"
+#include "triple_buffer.h"
+
+// one EQ band as the user sets it
+struct EqBand {
+    enum Type { OFF, LOW_SHELF, HIGH_SHELF, PEAKING, HIGH_PASS, LOW_PASS };
+    int type = OFF;
+    float hz = 1000.0f;
+    float db = 0.0f; // shelf and peaking gain
+    float q = 0.707f;
+};
+
+// coefficients of the enabled bands, normalized to a0 = 1
+struct EqDesign {
+    static const int MAX_SECTIONS = EQ_BANDS;
+    int sections = 0;
+    int band[MAX_SECTIONS]; // band each section belongs to, selects its filter state
+    float b0[MAX_SECTIONS];
+    float b1[MAX_SECTIONS];
+    float b2[MAX_SECTIONS];
+    float a1[MAX_SECTIONS];
+    float a2[MAX_SECTIONS];
+};
+
+// output equalizer: a cascade of biquads (RBJ cookbook shapes) in transposed
+// direct form II, applied to rendered frames. Coefficients are designed only
+// when a band changes, outside the audio path, and picked up by the render
+// path at block start through a triple buffer. Each section runs over the whole
+// block with its coefficients and state in locals; with every band off the
+// frames are not touched at all. Filter states are kept across redesigns so
+// moving a band does not click.
+class Equalizer {
+private:
+    EqBand bands[EQ_BANDS];
+    TripleBuffer<EqDesign> designs;
+    float statesLeft[EQ_BANDS][2] = {};
+    float statesRight[EQ_BANDS][2] = {};
+
+    static void addSection(EqDesign& design, int index, const EqBand& band, float sampleRate) {
+        const float w = 6.2831853f * band.hz / sampleRate;
+        const float cw = cosf(w);
+        const float alpha = sinf(w) / (2.0f * band.q);
+        const float a = powf(10.0f, band.db / 40.0f);
+        float b0, b1, b2, a0, a1, a2;
+        switch (band.type) {
+        case EqBand::LOW_SHELF:
+        case EqBand::HIGH_SHELF: {
+            const float sign = band.type == EqBand::LOW_SHELF ? 1.0f : -1.0f;
+            const float root = 2.0f * sqrtf(a) * alpha;
+            b0 = a * ((a + 1) - sign * (a - 1) * cw + root);
+            b1 = sign * 2 * a * ((a - 1) - sign * (a + 1) * cw);
+            b2 = a * ((a + 1) - sign * (a - 1) * cw - root);
+            a0 = (a + 1) + sign * (a - 1) * cw + root;
+            a1 = -sign * 2 * ((a - 1) + sign * (a + 1) * cw);
+            a2 = (a + 1) + sign * (a - 1) * cw - root;
+            break;
+        }
+        case EqBand::PEAKING:
+            b0 = 1 + alpha * a;
+            b1 = -2 * cw;
+            b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a;
+            a1 = -2 * cw;
+            a2 = 1 - alpha / a;
+            break;
+        case EqBand::HIGH_PASS:
+            b0 = (1 + cw) / 2;
+            b1 = -(1 + cw);
+            b2 = (1 + cw) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cw;
+            a2 = 1 - alpha;
+            break;
+        case EqBand::LOW_PASS:
+            b0 = (1 - cw) / 2;
+            b1 = 1 - cw;
+            b2 = (1 - cw) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cw;
+            a2 = 1 - alpha;
+            break;
+        default:
+            return;
+        }
+        const int n = design.sections++;
+        design.band[n] = index;
+        design.b0[n] = b0 / a0;
+        design.b1[n] = b1 / a0;
+        design.b2[n] = b2 / a0;
+        design.a1[n] = a1 / a0;
+        design.a2[n] = a2 / a0;
+    }
+
+    // one section over a block, in place
+    static void runSection(float* x, int32_t frameCount, float b0, float b1, float b2, float a1, float a2, float* state) {
+        float s1 = state[0], s2 = state[1];
+        for (int32_t i = 0; i < frameCount; i++) {
+            const float in = x[i];
+            const float out = b0 * in + s1;
+            s1 = b1 * in - a1 * out + s2;
+            s2 = b2 * in - a2 * out;
+            x[i] = out;
+        }
+        state[0] = s1;
+        state[1] = s2;
+    }
+
+public:
+    Equalizer() {
+        const float defaultHz[] = {100.0f, 1000.0f, 4000.0f, 10000.0f};
+        for (int i = 0; i < EQ_BANDS; i++) bands[i].hz = defaultHz[i < 4 ? i : 3];
+    }
+
+    // set a band and redesign, call from the control task, never from the audio path.
+    // Frequency is kept to 20 Hz..0.45 fs, gain to +/-18 dB and Q to 0.1..10.
+    void setBand(int index, const EqBand& band, float sampleRate = AUDIO_SAMPLE_RATE) {
+        if (index < 0 || index >= EQ_BANDS) return;
+        EqBand& b = bands[index];
+        b = band;
+        if (b.type < EqBand::OFF || b.type > EqBand::LOW_PASS) b.type = EqBand::OFF;
+        b.hz = fminf(fmaxf(b.hz, 20.0f), 0.45f * sampleRate);
+        b.db = fminf(fmaxf(b.db, -18.0f), 18.0f);
+        b.q = fminf(fmaxf(b.q, 0.1f), 10.0f);
+
+        EqDesign& design = designs.writeBuffer();
+        design.sections = 0;
+        for (int i = 0; i < EQ_BANDS; i++) addSection(design, i, bands[i], sampleRate);
+        designs.publish();
+    }
+
+    const EqBand& getBand(int index) const { return bands[index < 0 ? 0 : (index >= EQ_BANDS ? EQ_BANDS - 1 : index)]; }
+
+    // sections of the last design, control task side
+    int activeSections() const { return designs.latest().sections; }
+
+    // clear the filter states, call from the render path only
+    void reset() {
+        for (int i = 0; i < EQ_BANDS; i++) {
+            statesLeft[i][0] = statesLeft[i][1] = 0.0f;
+            statesRight[i][0] = statesRight[i][1] = 0.0f;
+        }
+    }
+
+    void process(Frame* data, int32_t frameCount) {
+        designs.update();
+        const EqDesign& design = designs.read();
+        const int sections = design.sections;
+        if (sections == 0) return;
+        float left[PCM_CHUNK_FRAMES];
+        float right[PCM_CHUNK_FRAMES];
+        for (int32_t offset = 0; offset < frameCount; offset += PCM_CHUNK_FRAMES) {
+            int32_t count = frameCount - offset < PCM_CHUNK_FRAMES ? frameCount - offset : PCM_CHUNK_FRAMES;
+            Frame* frames = data + offset;
+            for (int32_t i = 0; i < count; i++) {
+                left[i] = frames[i].channel1 * (1.0f / 32768.0f);
+                right[i] = frames[i].channel2 * (1.0f / 32768.0f);
+            }
+            for (int n = 0; n < sections; n++) {
+                const int band = design.band[n];
+                runSection(left, count, design.b0[n], design.b1[n], design.b2[n], design.a1[n], design.a2[n], statesLeft[band]);
+                runSection(right, count, design.b0[n], design.b1[n], design.b2[n], design.a1[n], design.a2[n], statesRight[band]);
+            }
+            pcmConverter.convert(left, right, frames, count);
+        }
+    }
+};
+
+#endif
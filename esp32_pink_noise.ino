@@ -1,13 +1,16 @@
 #include "button_handler.h"
 #include "audio_player.h"
+#include "bt_scan.h"
 #include "wifi_manager.h"
 #include <Preferences.h>
+#include <inttypes.h>
 #include "config.h"
 
 
 Preferences preferences;
 ButtonHandler buttonHandler;
 AudioPlayer audioPlayer;
+BtScan btScan(audioPlayer);
 
 AsyncWebServer* server = nullptr;
 
@@ -27,16 +30,14 @@ enum DeviceState {
 
 // global variables
 DeviceState deviceState = STATE_PLAYING;
-unsigned long scanStartTime = 0;
-const unsigned long SCAN_TIMEOUT = 15000;  // 15 seconds scan timeout
 
 // button callback functions
 void onVolumeUp() {
     if (deviceState == STATE_PLAYING) {
-        int newVolume = audioPlayer.getVolume() + volumeStep;
-        if(newVolume > 100) newVolume = 100;
-        audioPlayer.setVolume(newVolume);
-        preferences.putInt("Vol", newVolume);
+        int newVolume = audioPlayer.getFineVolume() + volumeStep * VOLUME_FINE_STEPS;
+        audioPlayer.setFineVolume(newVolume);
+        newVolume = audioPlayer.getFineVolume();
+        preferences.putInt("VolFine", newVolume);
         preferences.end();
         preferences.begin(prefKey, false);
         Serial.print("Vol Up: ");
@@ -46,10 +47,10 @@ void onVolumeUp() {
 
 void onVolumeDown() {
     if (deviceState == STATE_PLAYING) {
-        int newVolume = audioPlayer.getVolume() - volumeStep;
-        if(newVolume < 0) newVolume = 0;
-        audioPlayer.setVolume(newVolume);
-        preferences.putInt("Vol", newVolume);
+        int newVolume = audioPlayer.getFineVolume() - volumeStep * VOLUME_FINE_STEPS;
+        audioPlayer.setFineVolume(newVolume);
+        newVolume = audioPlayer.getFineVolume();
+        preferences.putInt("VolFine", newVolume);
         preferences.end();
         preferences.begin(prefKey, false);
         Serial.print("Vol Down: ");
@@ -67,11 +68,7 @@ void onMute() {
 void onNext() {
     if (deviceState == STATE_PLAYING) {
         audioPlayer.nextAlgorithm();
-        switch(audioPlayer.getCurrentAlgorithm()) {
-            case 0: Serial.println("0. Pink filter v2"); break;
-            case 1: Serial.println("1. Brown"); break;
-            default: Serial.println("2. Pink cursor"); break;
-        }
+        Serial.printf("%d. %s\n", audioPlayer.getCurrentAlgorithm(), audioPlayer.getAlgorithmName());
     }
 }
 
@@ -91,21 +88,13 @@ void handleDeviceState() {
         case STATE_SCAN_START:
             Serial.println("Scanning bluetooth devices");
             digitalWrite(LED_PIN, 1);
-            audioPlayer.startScan();
-            scanStartTime = currentTime;
+            btScan.start(currentTime, preferences.getString("btdev", defaultBtName).c_str());
             deviceState = STATE_SCAN_WAITING;
             break;
             
         case STATE_SCAN_WAITING:
-            digitalWrite(LED_PIN, ((currentTime - scanStartTime) / 500) % 2);
-            
-            if (currentTime - scanStartTime >= SCAN_TIMEOUT) {
-                auto devices = audioPlayer.getDevices();
-                Serial.print("Found devices: ");
-                Serial.println(devices->size());
-                
-                audioPlayer.stop();
-                
+            digitalWrite(LED_PIN, btScan.led(currentTime));
+            if (btScan.update(currentTime)) {
                 digitalWrite(LED_PIN, HIGH);
                 deviceState = STATE_WIFI_START;
             }
@@ -169,6 +158,39 @@ void onAllButtons() {
     }
 }
 
+// A2DP callback timing over the current window: render time histogram, frames per call, start jitter and worst case
+void readStats(JsonObject& stats) {
+    RenderStatsSnapshot s = audioPlayer.getRenderStats().snapshot();
+    stats["calls"] = s.calls;
+    stats["frames"] = s.frames;
+    stats["minFrames"] = s.minFrames;
+    stats["maxFrames"] = s.maxFrames;
+    stats["silentFrames"] = s.silentFrames;
+    stats["worstRenderUs"] = s.worstRenderUs;
+    stats["worstLoadPermille"] = s.worstLoadPermille;
+    stats["maxJitterUs"] = s.maxJitterUs;
+    stats["meanJitterUs"] = s.meanJitterUs;
+    stats["synthesisUsPerSecond"] = s.synthesisUsPerSecond;
+    stats["underruns"] = audioPlayer.getUnderruns();
+    JsonArray histogram = stats.createNestedArray("renderUsLog2Histogram");
+    for (int k = 0; k < RenderStatsSnapshot::BUCKETS; k++) histogram.add(s.histogram[k]);
+}
+
+void reportStats() {
+    RenderStatsSnapshot s = audioPlayer.getRenderStats().snapshot();
+    Serial.printf("stats: %" PRIu32 " calls, %" PRIu32 "-%" PRIu32 " frames/call, worst %" PRIu32 " us (%" PRIu32 ".%" PRIu32
+                  "%% of budget), jitter max %" PRIu32 " mean %" PRIu32 " us, silent %" PRIu32 ", underruns %" PRIu32
+                  ", synthesis %" PRIu32 " us per second of audio\n",
+                  s.calls, s.minFrames, s.maxFrames, s.worstRenderUs, s.worstLoadPermille / 10, s.worstLoadPermille % 10,
+                  s.maxJitterUs, s.meanJitterUs, s.silentFrames, audioPlayer.getUnderruns(), s.synthesisUsPerSecond);
+    Serial.print("stats: render us log2 histogram");
+    for (int k = 0; k < RenderStatsSnapshot::BUCKETS; k++) {
+        Serial.print(' ');
+        Serial.print(s.histogram[k]);
+    }
+    Serial.println();
+}
+
 char buf[40];
 void setup() {
     Serial.begin(115200);
@@ -176,17 +198,128 @@ void setup() {
     digitalWrite(LED_PIN, 1);
     Serial.println("Device started");
     setCpuFrequencyMhz(160);
+    seed_noise_generators();
     preferences.begin(prefKey, false);
+#if ADPCM_LOOP
+    if (SPIFFS.begin(true) && adpcmLoop.open()) Serial.printf("Uploaded loop: %.1f s\n", adpcmLoop.getSeconds());
+#endif
     
     // initialize button handler
     buttonHandler.init();
     buttonHandler.setCallbacks(onVolumeUp, onVolumeDown, onNext, onMute, onAllButtons);
     
-    int savedVolume = preferences.getInt("Vol", 50);
-    if(savedVolume < 10) savedVolume = 10;
-    audioPlayer.setVolume(savedVolume);
+    int savedVolume = preferences.getInt("VolFine", preferences.getInt("Vol", 50) * VOLUME_FINE_STEPS);
+    if(savedVolume < 10 * VOLUME_FINE_STEPS) savedVolume = 10 * VOLUME_FINE_STEPS;
+    audioPlayer.setFineVolume(savedVolume);
+    audioPlayer.setStereo(preferences.getBool("stereo", false));
+    audioPlayer.setNoiseSlope(preferences.getFloat("slope", -3.0f));
+    audioPlayer.setTone(preferences.getFloat("toneHz", TONE_CARRIER_HZ), preferences.getFloat("beatHz", TONE_BEAT_HZ),
+                        preferences.getInt("toneMode", TONE_MODE));
+    for (int i = 0; i < EQ_BANDS; i++) {
+        String key = String("eq") + i;
+        EqBand band = audioPlayer.getEqBand(i);
+        band.type = preferences.getInt((key + "Type").c_str(), band.type);
+        band.hz = preferences.getFloat((key + "Hz").c_str(), band.hz);
+        band.db = preferences.getFloat((key + "Db").c_str(), band.db);
+        band.q = preferences.getFloat((key + "Q").c_str(), band.q);
+        audioPlayer.setEqBand(i, band);
+    }
+    for (int i = 0; i < NoiseMixer::LAYERS; i++) {
+        String alg = String("mixAlg") + i, gain = String("mixGain") + i;
+        if (preferences.isKey(alg.c_str())) {
+            audioPlayer.setLayer(i, preferences.getInt(alg.c_str(), -1), preferences.getInt(gain.c_str(), 0) / 100.0f);
+        }
+    }
+
+    wifiManager.setStatsCallback(readStats);
+#if ADPCM_LOOP
+    wifiManager.setLoopUploadCallback([](size_t index, const uint8_t* data, size_t length, bool final) {
+        return adpcmLoop.upload(index, data, length, final);
+    });
+#endif
+    wifiManager.setSettingsCallbacks(
+        [](JsonObject& settings) {
+            settings["stereo"] = audioPlayer.getStereo();
+            settings["volume"] = audioPlayer.getFineVolume();
+            settings["slope"] = audioPlayer.getNoiseSlope();
+#if ADPCM_LOOP
+            settings["loopSeconds"] = adpcmLoop.getSeconds();
+#endif
+            settings["toneHz"] = audioPlayer.getToneCarrier();
+            settings["beatHz"] = audioPlayer.getToneBeat();
+            settings["toneMode"] = audioPlayer.getToneMode();
+            JsonArray algorithms = settings.createNestedArray("algorithms");
+            for (int i = 0; i < NOISE_ALGORITHM_COUNT; i++) algorithms.add(noiseAlgorithms[i].name);
+            for (int i = 0; i < NoiseMixer::LAYERS; i++) {
+                settings[String("layer") + i] = audioPlayer.getLayerAlgorithm(i);
+                settings[String("layer") + i + "Gain"] = static_cast<int>(audioPlayer.getLayerGain(i) * 100.0f + 0.5f);
+            }
+            for (int i = 0; i < EQ_BANDS; i++) {
+                String key = String("eq") + i;
+                const EqBand& band = audioPlayer.getEqBand(i);
+                settings[key + "Type"] = band.type;
+                settings[key + "Hz"] = band.hz;
+                settings[key + "Db"] = band.db;
+                settings[key + "Q"] = band.q;
+            }
+        },
+        [](JsonObject& settings) {
+            if (settings.containsKey("stereo")) {
+                audioPlayer.setStereo(settings["stereo"].as<bool>());
+                preferences.putBool("stereo", audioPlayer.getStereo());
+            }
+            if (settings.containsKey("volume")) {
+                audioPlayer.setFineVolume(settings["volume"].as<int>());
+                preferences.putInt("VolFine", audioPlayer.getFineVolume());
+            }
+            if (settings.containsKey("slope")) {
+                audioPlayer.setNoiseSlope(settings["slope"].as<float>());
+                preferences.putFloat("slope", audioPlayer.getNoiseSlope());
+            }
+            if (settings.containsKey("toneHz") || settings.containsKey("beatHz") || settings.containsKey("toneMode")) {
+                audioPlayer.setTone(settings.containsKey("toneHz") ? settings["toneHz"].as<float>() : audioPlayer.getToneCarrier(),
+                                    settings.containsKey("beatHz") ? settings["beatHz"].as<float>() : audioPlayer.getToneBeat(),
+                                    settings.containsKey("toneMode") ? settings["toneMode"].as<int>() : audioPlayer.getToneMode());
+                preferences.putFloat("toneHz", audioPlayer.getToneCarrier());
+                preferences.putFloat("beatHz", audioPlayer.getToneBeat());
+                preferences.putInt("toneMode", audioPlayer.getToneMode());
+            }
+            for (int i = 0; i < NoiseMixer::LAYERS; i++) {
+                String alg = String("layer") + i, gain = alg + "Gain";
+                if (!settings.containsKey(alg) && !settings.containsKey(gain)) continue;
+                int algorithm = settings.containsKey(alg) ? settings[alg].as<int>() : audioPlayer.getLayerAlgorithm(i);
+                float level = settings.containsKey(gain) ? settings[gain].as<int>() / 100.0f : audioPlayer.getLayerGain(i);
+                audioPlayer.setLayer(i, algorithm, level);
+                preferences.putInt((String("mixAlg") + i).c_str(), audioPlayer.getLayerAlgorithm(i));
+                preferences.putInt((String("mixGain") + i).c_str(), static_cast<int>(audioPlayer.getLayerGain(i) * 100.0f + 0.5f));
+            }
+            for (int i = 0; i < EQ_BANDS; i++) {
+                String key = String("eq") + i;
+                if (!settings.containsKey(key + "Type") && !settings.containsKey(key + "Hz") &&
+                    !settings.containsKey(key + "Db") && !settings.containsKey(key + "Q")) continue;
+                EqBand band = audioPlayer.getEqBand(i);
+                if (settings.containsKey(key + "Type")) band.type = settings[key + "Type"].as<int>();
+                if (settings.containsKey(key + "Hz")) band.hz = settings[key + "Hz"].as<float>();
+                if (settings.containsKey(key + "Db")) band.db = settings[key + "Db"].as<float>();
+                if (settings.containsKey(key + "Q")) band.q = settings[key + "Q"].as<float>();
+                audioPlayer.setEqBand(i, band);
+                band = audioPlayer.getEqBand(i);
+                preferences.putInt((key + "Type").c_str(), band.type);
+                preferences.putFloat((key + "Hz").c_str(), band.hz);
+                preferences.putFloat((key + "Db").c_str(), band.db);
+                preferences.putFloat((key + "Q").c_str(), band.q);
+            }
+            preferences.end();
+            preferences.begin(prefKey, false);
+        });
     strcpy(buf, defaultBtName);
     String deviceName = preferences.getString("btdev", buf);
+#if AUDIO_OUTPUT == AUDIO_OUTPUT_I2S
+    // the DAC needs no speaker, play right away instead of scanning for one
+    deviceState = STATE_PLAYING;
+    audioPlayer.init(deviceName.c_str());
+    Serial.println("Playing pink noise on the I2S DAC");
+#else
     if (deviceName.length() > 0) {
       deviceState = STATE_PLAYING;
       audioPlayer.init(deviceName.c_str());
@@ -196,6 +329,7 @@ void setup() {
         Serial.println("No device selected");
         deviceState = STATE_SCAN_START;
     }
+#endif
     delay(100);
     digitalWrite(LED_PIN, 0);
 }
@@ -203,6 +337,17 @@ void setup() {
 void loop() {
     buttonHandler.update();
     handleDeviceState();
+
+#if RENDER_STATS
+    static unsigned long lastReport = 0;
+    if (deviceState == STATE_PLAYING && millis() - lastReport >= RENDER_STATS_REPORT_MS) {
+        lastReport = millis();
+#if RENDER_STATS_SERIAL
+        reportStats();
+#endif
+        audioPlayer.getRenderStats().reset(); // next window, the 32-bit sums stay far from wrapping
+    }
+#endif
     
     // if button is pressed and playing sound, should frequently check button status
     if (buttonHandler.isActive() && deviceState == STATE_PLAYING) {
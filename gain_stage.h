@@ -0,0 +1,83 @@
+#ifndef GAIN_STAGE_H
+#define GAIN_STAGE_H
+
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "constexpr_math.h"
+
+constexpr double db_to_linear(double db) {
+    return constexpr_exp(db * 0.11512925464970229); // ln(10) / 20
+}
+
+// attenuation table in GAIN_TABLE_STEP_DB steps, Q15 with 32768 as unity, generated by the compiler
+struct GainTable {
+    static const int SIZE = GAIN_TABLE_SIZE;
+    int32_t q15[SIZE];
+
+    constexpr GainTable() : q15{} {
+        for (int i = 0; i < SIZE; i++) {
+            q15[i] = static_cast<int32_t>(32768.0 * db_to_linear(-GAIN_TABLE_STEP_DB * i) + 0.5);
+        }
+    }
+};
+
+constexpr GainTable gainTable;
+
+// attenuation in table steps for a volume in 0..100 * VOLUME_FINE_STEPS: linear
+// in dB from unity at full volume to VOLUME_RANGE_DB at the lowest step, 0 mutes
+constexpr int volume_attenuation(int fineVolume) {
+    return fineVolume <= 0 ? GainTable::SIZE
+                           : static_cast<int>((100 * VOLUME_FINE_STEPS - fineVolume) * (VOLUME_RANGE_DB / GAIN_TABLE_STEP_DB) /
+                                                  (100 * VOLUME_FINE_STEPS) + 0.5);
+}
+
+static_assert(VOLUME_RANGE_DB / GAIN_TABLE_STEP_DB < GAIN_TABLE_SIZE, "VOLUME_RANGE_DB is beyond the gain table");
+
+// software gain applied to rendered frames. The gain moves toward its target
+// by at most one ramp step per frame, so changes are smooth and monotonic.
+class GainStage {
+private:
+    static const int32_t UNITY = 32768;
+    int32_t current = UNITY;
+    int32_t target = UNITY;
+    int32_t rampStep = 1;
+
+public:
+    // full-scale ramp time, a change from unity to silence takes this long
+    void setRampTime(uint32_t milliseconds, uint32_t sampleRate) {
+        uint32_t frames = static_cast<uint32_t>(static_cast<uint64_t>(sampleRate) * milliseconds / 1000);
+        rampStep = frames ? static_cast<int32_t>((UNITY + frames - 1) / frames) : UNITY;
+    }
+
+    // attenuation in table steps, out-of-range values mute
+    void setAttenuation(int steps) {
+        target = steps < 0 ? UNITY : (steps >= GainTable::SIZE ? 0 : gainTable.q15[steps]);
+    }
+
+    void setMuted() { target = 0; }
+
+    bool isUnity() const { return current == UNITY && target == UNITY; }
+
+    void process(Frame* data, int32_t frameCount) {
+        int32_t gain = current;
+        if (gain == target) {
+            if (gain == UNITY) return;
+            for (int32_t i = 0; i < frameCount; i++) {
+                data[i].channel1 = static_cast<int16_t>((data[i].channel1 * gain) >> 15);
+                data[i].channel2 = static_cast<int16_t>((data[i].channel2 * gain) >> 15);
+            }
+            return;
+        }
+        const int32_t goal = target;
+        const int32_t step = goal > gain ? rampStep : -rampStep;
+        for (int32_t i = 0; i < frameCount; i++) {
+            gain += step;
+            if ((step > 0 && gain > goal) || (step < 0 && gain < goal)) gain = goal;
+            data[i].channel1 = static_cast<int16_t>((data[i].channel1 * gain) >> 15);
+            data[i].channel2 = static_cast<int16_t>((data[i].channel2 * gain) >> 15);
+        }
+        current = gain;
+    }
+};
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef MODULATION_H
+#define MODULATION_H
+
+#include <math.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "noise_random.h"
+#include "pcm_convert.h"
+#include "pink_noise.h"
+#include "sine_table.h"
+
+// slow modulation source with an output in [0, 1], stepped once per control block.
+// SINE is a plain LFO, WAVE a squared one that lingers in the trough and crests
+// briefly, RANDOM glides with a raised cosine to a new random level every period.
+class Modulator {
+public:
+    enum Shape { SINE, WAVE, RANDOM };
+
+private:
+    Shape shape = SINE;
+    uint32_t phase = 0;
+    uint32_t step = 0; // phase per control block
+    float from = 0.5f; // random segment end points
+    float to = 0.5f;
+
+public:
+    void setShape(Shape newShape) { shape = newShape; }
+
+    void setRate(float hz, int32_t controlFrames) {
+        step = static_cast<uint32_t>(static_cast<double>(hz) * 4294967296.0 * controlFrames / AUDIO_SAMPLE_RATE);
+    }
+
+    void reset() {
+        phase = 0;
+        from = to = 0.5f;
+    }
+
+    float next(NoiseRandom& rng) {
+        const uint32_t previous = phase;
+        phase += step;
+        if (shape == RANDOM) {
+            if (phase < previous) { // wrapped, start a new segment
+                from = to;
+                to = 0.5f + 0.5f * rng.nextFloat();
+            }
+            float s = 0.5f + 0.5f * sine_lookup((phase >> 1) - 0x40000000u); // 0 to 1 over the segment
+            return from + (to - from) * s;
+        }
+        float s = 0.5f + 0.5f * sine_lookup(phase);
+        return shape == WAVE ? s * s : s;
+    }
+};
+
+// a modulated soundscape: brown and pink noise mixed, then a one-pole lowpass.
+// A swell envelope, scaled by a slower drift, sets both the level and the
+// cutoff, so the sound gets louder and brighter together.
+struct ModulationPatch {
+    float brown;            // base mix
+    float pink;
+    Modulator::Shape swellShape;
+    float swellHz;
+    Modulator::Shape driftShape;
+    float driftHz;
+    float driftDepth;       // share of the swell the drift can take away
+    float minLevel;         // level at the bottom of the swell
+    float lowHz;            // cutoff at the bottom and top of the swell
+    float highHz;
+};
+
+constexpr ModulationPatch OCEAN_WAVES = {0.25f, 0.9f, Modulator::WAVE, 0.1f, Modulator::RANDOM, 0.04f, 0.5f, 0.1f, 250.0f, 2500.0f};
+constexpr ModulationPatch RAIN_SWELLS = {0.1f, 0.8f, Modulator::RANDOM, 0.25f, Modulator::RANDOM, 0.05f, 0.5f, 0.5f, 2000.0f, 9000.0f};
+
+// The modulators run every MODULATION_CONTROL_FRAMES frames and only the filter
+// coefficient and the gain are ramped per sample, so the modulation costs two
+// additions per frame on top of the noise and the filter. The noise comes from
+// float generators of its own, also with NOISE_FIXED_POINT.
+class ModulatedNoise {
+private:
+    ModulationPatch patch;
+    PinkNoiseFilterV2<> pink;
+    PinkNoiseFilterV2<> pinkRight;
+    BrownNoiseGenerator<> brown;
+    BrownNoiseGenerator<> brownRight;
+    NoiseRandom controlRandom;
+    Modulator swell;
+    Modulator drift;
+    int32_t controlInterval = MODULATION_CONTROL_FRAMES;
+    int32_t controlFrames = 0; // frames left in the current control block
+    float gain = 0.0f;         // values at the end of the last frame, render path only
+    float gainStep = 0.0f;
+    float coeff = 0.0f;
+    float coeffStep = 0.0f;
+    float lowpass = 0.0f;
+    float lowpassRight = 0.0f;
+
+    void nextControlBlock() {
+        const float envelope = swell.next(controlRandom) * (1.0f - patch.driftDepth + patch.driftDepth * drift.next(controlRandom));
+        const float level = patch.minLevel + (1.0f - patch.minLevel) * envelope;
+        const float cutoff = patch.lowHz + (patch.highHz - patch.lowHz) * envelope;
+        const float target = 1.0f - expf(-6.2831853f * cutoff / AUDIO_SAMPLE_RATE);
+        gainStep = (level - gain) / controlInterval;
+        coeffStep = (target - coeff) / controlInterval;
+        controlFrames = controlInterval;
+    }
+
+public:
+    static const int RANDOM_SOURCES = 5;
+
+    explicit ModulatedNoise(const ModulationPatch& patch) : patch(patch) { setControlInterval(MODULATION_CONTROL_FRAMES); }
+
+    // random streams to seed: the four noise generators and the modulators
+    NoiseRandom& random(int index) {
+        switch (index) {
+        case 0: return pink.random();
+        case 1: return pinkRight.random();
+        case 2: return brown.random();
+        case 3: return brownRight.random();
+        default: return controlRandom;
+        }
+    }
+
+    // frames between modulator updates, 1 evaluates them per sample
+    void setControlInterval(int32_t frames) {
+        controlInterval = frames < 1 ? 1 : frames;
+        controlFrames = 0;
+        swell.setShape(patch.swellShape);
+        swell.setRate(patch.swellHz, controlInterval);
+        drift.setShape(patch.driftShape);
+        drift.setRate(patch.driftHz, controlInterval);
+    }
+
+    // start at the bottom of the swell, the noise streams continue
+    void reset() {
+        pink.reset();
+        pinkRight.reset();
+        brown.reset();
+        brownRight.reset();
+        swell.reset();
+        drift.reset();
+        controlFrames = 0;
+        gain = 0.0f;
+        coeff = 0.0f;
+        lowpass = 0.0f;
+        lowpassRight = 0.0f;
+    }
+
+    void renderBlock(float* left, float* right, int32_t frameCount, bool stereo) {
+        float pinkBlock[PCM_CHUNK_FRAMES];
+        float pinkBlockRight[PCM_CHUNK_FRAMES];
+        float brownBlock[PCM_CHUNK_FRAMES];
+        float brownBlockRight[PCM_CHUNK_FRAMES];
+        const float brownGain = patch.brown;
+        const float pinkGain = patch.pink;
+        int32_t offset = 0;
+        while (offset < frameCount) {
+            if (controlFrames == 0) nextControlBlock();
+            int32_t count = frameCount - offset;
+            if (count > controlFrames) count = controlFrames;
+            if (count > PCM_CHUNK_FRAMES) count = PCM_CHUNK_FRAMES;
+            controlFrames -= count;
+
+            float g = gain, a = coeff, yl = lowpass;
+            if (stereo) {
+                pink.renderBlock(pinkBlock, pinkBlockRight, count, pinkRight);
+                brown.renderBlock(brownBlock, brownBlockRight, count, brownRight);
+                float yr = lowpassRight;
+                for (int32_t i = 0; i < count; i++) {
+                    g += gainStep;
+                    a += coeffStep;
+                    yl += a * (brownGain * brownBlock[i] + pinkGain * pinkBlock[i] - yl);
+                    yr += a * (brownGain * brownBlockRight[i] + pinkGain * pinkBlockRight[i] - yr);
+                    left[offset + i] = yl * g;
+                    right[offset + i] = yr * g;
+                }
+                lowpassRight = yr;
+            } else {
+                pink.renderBlock(pinkBlock, count);
+                brown.renderBlock(brownBlock, count);
+                for (int32_t i = 0; i < count; i++) {
+                    g += gainStep;
+                    a += coeffStep;
+                    yl += a * (brownGain * brownBlock[i] + pinkGain * pinkBlock[i] - yl);
+                    left[offset + i] = yl * g;
+                }
+            }
+            gain = g;
+            coeff = a;
+            lowpass = yl;
+            offset += count;
+        }
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount, bool stereo) {
+        float blockLeft[PCM_CHUNK_FRAMES];
+        float blockRight[PCM_CHUNK_FRAMES];
+        for (int32_t offset = 0; offset < frameCount; offset += PCM_CHUNK_FRAMES) {
+            int32_t count = frameCount - offset < PCM_CHUNK_FRAMES ? frameCount - offset : PCM_CHUNK_FRAMES;
+            renderBlock(blockLeft, blockRight, count, stereo);
+            if (stereo) pcmConverter.convert(blockLeft, blockRight, data + offset, count);
+            else pcmConverter.convert(blockLeft, data + offset, count);
+        }
+    }
+};
+
+ModulatedNoise oceanWaves(OCEAN_WAVES);
+ModulatedNoise rainSwells(RAIN_SWELLS);
+
+// registry entry points for a modulated soundscape
+template <ModulatedNoise& Noise>
+void render_modulated(Frame* data, int32_t frameCount, bool stereo) { Noise.renderBlock(data, frameCount, stereo); }
+
+template <ModulatedNoise& Noise>
+void render_modulated_float(float* left, float* right, int32_t frameCount, bool stereo) { Noise.renderBlock(left, right, frameCount, stereo); }
+
+template <ModulatedNoise& Noise>
+void reset_modulated() { Noise.reset(); }
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef NOISE_ALGORITHM_H
+#define NOISE_ALGORITHM_H
+
+#include <type_traits>
+#include <utility>
+#include <BluetoothA2DPSource.h>
+
+// a selectable sound: the player calls render once per block, never per sample
+struct NoiseAlgorithm {
+    const char* name;
+    void (*render)(Frame* data, int32_t frameCount, bool stereo);
+    size_t stateSize; // bytes of generator state, both channels
+    void (*reset)();  // clears the generator state, called from the render path
+    // float [-1, 1] block before PCM conversion, used by the mixer; nullptr for
+    // generators that only produce PCM. "right" is only written in stereo.
+    void (*renderFloat)(float* left, float* right, int32_t frameCount, bool stereo);
+    bool alwaysStereo; // renders both channels even in mono mode, e.g. binaural tones
+};
+
+// true when the generator renders float blocks
+template <typename Generator, typename = void>
+struct has_float_render : std::false_type {};
+
+template <typename Generator>
+struct has_float_render<Generator, decltype(std::declval<Generator&>().renderBlock(static_cast<float*>(nullptr), int32_t(0)), void())>
+    : std::true_type {};
+
+// render and reset for a generator pair, one instantiation per registered algorithm
+template <typename Generator, Generator& Left, Generator& Right>
+void render_generator(Frame* data, int32_t frameCount, bool stereo) {
+    if (stereo) Left.renderBlock(data, frameCount, Right);
+    else Left.renderBlock(data, frameCount);
+}
+
+template <typename Generator, Generator& Left, Generator& Right>
+void reset_generator() {
+    Left.reset();
+    Right.reset();
+}
+
+template <typename Generator, Generator& Left, Generator& Right, bool Float = has_float_render<Generator>::value>
+struct FloatRender {
+    static constexpr void (*function)(float*, float*, int32_t, bool) = nullptr;
+};
+
+template <typename Generator, Generator& Left, Generator& Right>
+struct FloatRender<Generator, Left, Right, true> {
+    static void render(float* left, float* right, int32_t frameCount, bool stereo) {
+        if (stereo) Left.renderBlock(left, right, frameCount, Right);
+        else Left.renderBlock(left, frameCount);
+    }
+
+    static constexpr void (*function)(float*, float*, int32_t, bool) = render;
+};
+
+template <typename Generator, Generator& Left, Generator& Right>
+constexpr NoiseAlgorithm noise_algorithm(const char* name) {
+    return {name, render_generator<Generator, Left, Right>, 2 * sizeof(Generator), reset_generator<Generator, Left, Right>,
+            FloatRender<Generator, Left, Right>::function, false};
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef NOISE_LOOP_H
+#define NOISE_LOOP_H
+
+#include <Arduino.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+
+// precomputed seamless noise loop, generated by tools/make_noise_loop into noise_loop.cpp.
+// The array is const data in flash and is read through the flash cache, so playback
+// is a copy with no synthesis.
+extern const int16_t NOISE_LOOP_SAMPLES[];
+extern const uint32_t NOISE_LOOP_LENGTH;
+
+class NoiseLoopPlayer {
+private:
+    uint32_t start;
+    uint32_t position;
+
+public:
+    // the right channel starts half a loop later so the two channels are uncorrelated
+    explicit NoiseLoopPlayer(bool halfway = false) : start(halfway ? NOISE_LOOP_LENGTH / 2 : 0), position(start) {}
+
+    void reset() { position = start; }
+
+    void renderBlock(Frame* data, int32_t frameCount) {
+        uint32_t pos = position;
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(NOISE_LOOP_SAMPLES[pos]);
+            if (++pos == NOISE_LOOP_LENGTH) pos = 0;
+        }
+        position = pos;
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount, NoiseLoopPlayer& right) {
+        uint32_t pos = position;
+        uint32_t posRight = right.position;
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(NOISE_LOOP_SAMPLES[pos], NOISE_LOOP_SAMPLES[posRight]);
+            if (++pos == NOISE_LOOP_LENGTH) pos = 0;
+            if (++posRight == NOISE_LOOP_LENGTH) posRight = 0;
+        }
+        position = pos;
+        right.position = posRight;
+    }
+};
+
+NoiseLoopPlayer noiseLoop;
+NoiseLoopPlayer noiseLoopRight(true);
+
+#endif
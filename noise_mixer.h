@@ -0,0 +1,204 @@
+#ifndef NOISE_MIXER_H
+#define NOISE_MIXER_H
+
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "noise_algorithm.h"
+#include "pcm_convert.h"
+#include "triple_buffer.h"
+
+void render_mixer(Frame* data, int32_t frameCount, bool stereo);
+
+// soundscape mixer: up to MIXER_LAYERS registered sounds, each with its own
+// gain, summed in one float block and converted to PCM once. Layers whose gain
+// is and stays zero are not rendered at all. Sounds without a float path are
+// rendered to PCM and added back as float. A layer's gain moves to its target
+// within GAIN_RAMP_MS, in linear steps across each block. The layers share the
+// registry's generators: a sound in several layers is rendered once per block
+// at the sum of their gains, and while the player crossfades between the mix
+// and one of its layers it renders that generator once and passes the block
+// in, see render(). Layer settings are handed from the control task to the
+// render path through a triple buffer, picked up by update() at block start.
+class NoiseMixer {
+public:
+    static const int LAYERS = MIXER_LAYERS;
+
+private:
+    // the layers as the control task sets them
+    struct LayerSettings {
+        const NoiseAlgorithm* source[LAYERS] = {};
+        float gain[LAYERS] = {};
+    };
+
+    // render path only
+    struct Layer {
+        const NoiseAlgorithm* source = nullptr;
+        float gain = 0.0f;   // gain at the end of the last rendered block
+        float target = 0.0f;
+
+        // rendered: it has a source and a gain that is or will be non-zero
+        bool audible() const { return source && (gain != 0.0f || target != 0.0f); }
+    };
+
+    LayerSettings settings; // control task only
+    TripleBuffer<LayerSettings> snapshots;
+    Layer layers[LAYERS];
+    float maxStep = 1.0f; // largest gain change per frame
+
+public:
+    NoiseMixer() {
+        uint32_t rampFrames = static_cast<uint32_t>(static_cast<uint64_t>(AUDIO_SAMPLE_RATE) * GAIN_RAMP_MS / 1000);
+        maxStep = rampFrames ? 1.0f / rampFrames : 1.0f;
+    }
+
+    // source nullptr empties the layer, a new source fades in from silence. Call from the control task.
+    void setLayer(int index, const NoiseAlgorithm* source, float gain) {
+        if (index < 0 || index >= LAYERS) return;
+        if (source && source->render == render_mixer) source = nullptr; // no nested mixers
+        settings.source[index] = source;
+        settings.gain[index] = gain < 0.0f ? 0.0f : gain;
+        snapshots.writeBuffer() = settings;
+        snapshots.publish();
+    }
+
+    void setLayerGain(int index, float gain) {
+        if (index < 0 || index >= LAYERS) return;
+        setLayer(index, settings.source[index], gain);
+    }
+
+    const NoiseAlgorithm* getLayerSource(int index) const { return index >= 0 && index < LAYERS ? settings.source[index] : nullptr; }
+
+    float getLayerGain(int index) const { return index >= 0 && index < LAYERS ? settings.gain[index] : 0.0f; }
+
+    // render path: take the newest layer settings, call at block start before
+    // hasLayer() or render() so one block sees one set of layers
+    void update() {
+        if (!snapshots.update()) return;
+        const LayerSettings& next = snapshots.read();
+        for (int i = 0; i < LAYERS; i++) {
+            if (next.source[i] != layers[i].source) {
+                layers[i].source = next.source[i];
+                layers[i].gain = 0.0f;
+            }
+            layers[i].target = next.gain[i];
+        }
+    }
+
+    // number of layers that are rendered: they have a source and a gain that is or will be non-zero
+    int activeLayers() const {
+        int count = 0;
+        for (const Layer& layer : layers) {
+            if (layer.audible()) count++;
+        }
+        return count;
+    }
+
+    // whether source is a layer, rendered or not
+    bool hasLayer(const NoiseAlgorithm* source) const {
+        for (const Layer& layer : layers) {
+            if (source && layer.source == source) return true;
+        }
+        return false;
+    }
+
+    // reset the layers' generators, except keep, which plays on elsewhere
+    void reset(const NoiseAlgorithm* keep = nullptr) {
+        for (Layer& layer : layers) {
+            if (layer.source && layer.source != keep) layer.source->reset();
+        }
+    }
+
+    // shared is a layer whose block has already been rendered into sharedBlock
+    // (frameCount frames, same stereo flag): it is mixed from there instead of
+    // being rendered a second time, which would advance its generator twice.
+    void render(Frame* data, int32_t frameCount, bool stereo, const NoiseAlgorithm* shared = nullptr, const Frame* sharedBlock = nullptr) {
+        float mixLeft[PCM_CHUNK_FRAMES];
+        float mixRight[PCM_CHUNK_FRAMES];
+        float left[PCM_CHUNK_FRAMES];
+        float right[PCM_CHUNK_FRAMES];
+        // a layer that always renders stereo (a binaural tone) makes the whole mix stereo
+        bool mixStereo = stereo;
+        for (const Layer& layer : layers) {
+            if (layer.audible() && layer.source->alwaysStereo) mixStereo = true;
+        }
+        for (int32_t offset = 0; offset < frameCount; offset += PCM_CHUNK_FRAMES) {
+            int32_t count = frameCount - offset < PCM_CHUNK_FRAMES ? frameCount - offset : PCM_CHUNK_FRAMES;
+            for (int32_t i = 0; i < count; i++) {
+                mixLeft[i] = 0.0f;
+                mixRight[i] = 0.0f;
+            }
+
+            for (int l = 0; l < LAYERS; l++) {
+                if (!layers[l].audible()) continue;
+                const NoiseAlgorithm* source = layers[l].source;
+                bool mixed = false; // already rendered for an earlier layer
+                for (int k = 0; k < l; k++) mixed = mixed || (layers[k].source == source && layers[k].audible());
+                if (mixed) continue;
+
+                // every layer of this source ramps on its own, the sums ramp linearly as well
+                const float limit = maxStep * count;
+                float from = 0.0f, to = 0.0f;
+                for (int k = l; k < LAYERS; k++) {
+                    Layer& layer = layers[k];
+                    if (layer.source != source) continue;
+                    float target = layer.target;
+                    if (target > layer.gain + limit) target = layer.gain + limit;
+                    if (target < layer.gain - limit) target = layer.gain - limit;
+                    from += layer.gain;
+                    to += target;
+                    layer.gain = target;
+                }
+
+                const bool layerStereo = stereo || source->alwaysStereo;
+                if (source == shared) {
+                    for (int32_t i = 0; i < count; i++) {
+                        left[i] = sharedBlock[offset + i].channel1 * (1.0f / 32768.0f);
+                        right[i] = sharedBlock[offset + i].channel2 * (1.0f / 32768.0f);
+                    }
+                } else if (source->renderFloat) {
+                    source->renderFloat(left, right, count, layerStereo);
+                } else {
+                    Frame* pcm = data + offset; // not written yet, used as scratch
+                    source->render(pcm, count, layerStereo);
+                    for (int32_t i = 0; i < count; i++) {
+                        left[i] = pcm[i].channel1 * (1.0f / 32768.0f);
+                        right[i] = pcm[i].channel2 * (1.0f / 32768.0f);
+                    }
+                }
+
+                const float step = (to - from) / count;
+                float gain = from;
+                if (layerStereo) {
+                    for (int32_t i = 0; i < count; i++) {
+                        gain += step;
+                        mixLeft[i] += left[i] * gain;
+                        mixRight[i] += right[i] * gain;
+                    }
+                } else if (mixStereo) {
+                    for (int32_t i = 0; i < count; i++) {
+                        gain += step;
+                        mixLeft[i] += left[i] * gain;
+                        mixRight[i] += left[i] * gain;
+                    }
+                } else {
+                    for (int32_t i = 0; i < count; i++) {
+                        gain += step;
+                        mixLeft[i] += left[i] * gain;
+                    }
+                }
+            }
+
+            if (mixStereo) pcmConverter.convert(mixLeft, mixRight, data + offset, count);
+            else pcmConverter.convert(mixLeft, data + offset, count);
+        }
+    }
+};
+
+NoiseMixer noiseMixer;
+
+// registry entry points
+void render_mixer(Frame* data, int32_t frameCount, bool stereo) { noiseMixer.render(data, frameCount, stereo); }
+
+void reset_mixer() { noiseMixer.reset(); }
+
+#endif
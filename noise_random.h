@@ -0,0 +1,85 @@
+#ifndef NOISE_RANDOM_H
+#define NOISE_RANDOM_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// xorshift32 engine: three shifts per value, cheap on the 32-bit Xtensa core
+class XorShift32 {
+private:
+    uint32_t state = 2463534242u;
+
+public:
+    void seed(uint32_t value) { state = value ? value : 2463534242u; } // zero is a fixed point
+
+    uint32_t next() {
+        uint32_t x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state = x;
+        return x;
+    }
+};
+
+// PCG32 (XSH-RR) engine: better statistics than xorshift at the cost of a 64-bit multiply
+class Pcg32 {
+private:
+    uint64_t state = 0x853c49e6748fea9bULL;
+
+public:
+    void seed(uint32_t value) {
+        state = 0;
+        next();
+        state += 0x853c49e6748fea9bULL ^ value;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+};
+
+// white noise source with explicit state, every generator owns one so nothing
+// is shared with libc rand() or between generators
+template <typename Engine>
+class BasicNoiseRandom {
+private:
+    Engine engine;
+
+public:
+    void seed(uint32_t value) { engine.seed(value); }
+
+    // seed from the ESP32 hardware RNG; host builds have none and take hostSeed,
+    // which has to differ between generators or their outputs are identical
+    void seedFromHardware(uint32_t hostSeed) {
+#ifdef ESP_PLATFORM
+        (void)hostSeed;
+        engine.seed(esp_random());
+#else
+        engine.seed(hostSeed);
+#endif
+    }
+
+    // uniform int32 over the full range
+    int32_t nextInt() { return static_cast<int32_t>(engine.next()); }
+
+    // uniform float in [-1, 1), scaled by a multiply instead of a divide
+    float nextFloat() { return nextInt() * (1.0f / 2147483648.0f); }
+
+    void fillInt(int32_t* out, int32_t count) {
+        for (int32_t i = 0; i < count; i++) out[i] = nextInt();
+    }
+
+    void fillFloat(float* out, int32_t count) {
+        for (int32_t i = 0; i < count; i++) out[i] = nextFloat();
+    }
+};
+
+typedef BasicNoiseRandom<NOISE_RANDOM_ENGINE> NoiseRandom;
+
+#endif
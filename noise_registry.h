@@ -0,0 +1,74 @@
+#ifndef NOISE_REGISTRY_H
+#define NOISE_REGISTRY_H
+
+#include <string.h>
+#include "config.h"
+#include "noise_algorithm.h"
+#include "noise_mixer.h"
+#include "pink_noise.h"
+#include "colored_noise.h"
+#include "tone_generator.h"
+#include "modulation.h"
+#if NOISE_LOOP
+#include "noise_loop.h"
+#endif
+#if ADPCM_LOOP
+#include "adpcm_loop.h"
+#endif
+
+// the registry, in the order the next button steps through it. Adding a sound
+// is one line here; the index is what the player stores as the algorithm.
+constexpr NoiseAlgorithm noiseAlgorithms[] = {
+    noise_algorithm<PinkNoiseFilter, pinkNoiseFilterV2, pinkNoiseFilterV2Right>("Pink filter v2"),
+    noise_algorithm<BrownNoise, brownNoiseGenerator, brownNoiseGeneratorRight>("Brown"),
+    noise_algorithm<PinkNoiseCursor, pinkNoiseCursor, pinkNoiseCursorRight>("Pink cursor"),
+    noise_algorithm<VossMcCartneyPinkNoise<>, vossPinkNoise, vossPinkNoiseRight>("Pink Voss-McCartney"),
+    noise_algorithm<ColoredNoiseGenerator, blueNoise, blueNoiseRight>("Blue"),
+    noise_algorithm<ColoredNoiseGenerator, violetNoise, violetNoiseRight>("Violet"),
+    noise_algorithm<ColoredNoiseGenerator, greyNoise, greyNoiseRight>("Grey"),
+    noise_algorithm<ColoredNoiseGenerator, customNoise, customNoiseRight>("Custom slope"),
+    {"Soundscape", render_mixer, sizeof(NoiseMixer), reset_mixer, nullptr, false},
+    {"Tone", render_tone, sizeof(ToneGenerator), reset_tone, render_tone_float, true},
+    {"Ocean waves", render_modulated<oceanWaves>, sizeof(ModulatedNoise), reset_modulated<oceanWaves>, render_modulated_float<oceanWaves>, false},
+    {"Rain swells", render_modulated<rainSwells>, sizeof(ModulatedNoise), reset_modulated<rainSwells>, render_modulated_float<rainSwells>, false},
+#if NOISE_LOOP
+    noise_algorithm<NoiseLoopPlayer, noiseLoop, noiseLoopRight>("Flash loop"),
+#endif
+#if ADPCM_LOOP
+    {"Uploaded loop", render_adpcm_loop, sizeof(AdpcmLoopPlayer), reset_adpcm_loop, nullptr, false},
+#endif
+};
+
+constexpr int NOISE_ALGORITHM_COUNT = sizeof(noiseAlgorithms) / sizeof(noiseAlgorithms[0]);
+
+// registry index of a sound by name, -1 when there is none
+inline int find_noise_algorithm(const char* name) {
+    for (int i = 0; i < NOISE_ALGORITHM_COUNT; i++) {
+        if (!strcmp(noiseAlgorithms[i].name, name)) return i;
+    }
+    return -1;
+}
+
+// seed every generator, from the hardware RNG unless NOISE_FIXED_SEED is set for reproducible runs;
+// fixed and host seeds are spread by the generator's index so no two sources share a sequence
+void seed_noise_generators() {
+    NoiseRandom* sources[] = { &pinkNoiseCursor.random(), &pinkNoiseFilterV2.random(), &brownNoiseGenerator.random(),
+                               &vossPinkNoise.random(), &pinkNoiseCursorRight.random(), &pinkNoiseFilterV2Right.random(),
+                               &brownNoiseGeneratorRight.random(), &vossPinkNoiseRight.random(), &pcmConverter.random(),
+                               &blueNoise.random(), &blueNoiseRight.random(), &violetNoise.random(), &violetNoiseRight.random(),
+                               &greyNoise.random(), &greyNoiseRight.random(), &customNoise.random(), &customNoiseRight.random() };
+    ModulatedNoise* modulated[] = { &oceanWaves, &rainSwells };
+    uint32_t index = 0;
+    auto seed = [&index](NoiseRandom& source) {
+        const uint32_t spread = index * 0x9E3779B9u;
+        if (NOISE_FIXED_SEED) source.seed(NOISE_FIXED_SEED + spread);
+        else source.seedFromHardware(0x5EED + spread);
+        index++;
+    };
+    for (NoiseRandom* source : sources) seed(*source);
+    for (ModulatedNoise* noise : modulated) {
+        for (int k = 0; k < ModulatedNoise::RANDOM_SOURCES; k++) seed(noise->random(k));
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef PCM_CONVERT_H
+#define PCM_CONVERT_H
+
+#include <string.h>
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "noise_random.h"
+
+inline int16_t saturate_pcm(int32_t value) {
+    return static_cast<int16_t>(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+}
+
+// float [-1, 1] to 16-bit conversion. Out-of-range samples are clamped before the
+// integer conversion, which is undefined for values that do not fit. The clamp
+// is an integer min on the magnitude bits, because float compares are not
+// if-converted under trapping math; it also maps infinities and NaN to full
+// scale. Rounding uses an offset truncation, so the loop is straight-line code
+// the compiler can vectorize. Optional TPDF dither adds two independent
+// +/-0.5 LSB uniform values taken from one random word.
+class PcmConverter {
+private:
+    NoiseRandom ditherRandom;
+    bool dither = PCM_DITHER;
+
+    static int16_t toPcm(float value) {
+        const uint32_t one = 0x3F800000u; // bit pattern of 1.0f
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+        magnitude = magnitude < one ? magnitude : one;
+        bits = (bits & 0x80000000u) | magnitude;
+        float clamped;
+        memcpy(&clamped, &bits, sizeof(clamped));
+        return static_cast<int16_t>(static_cast<int32_t>(clamped * 32767.0f + 32768.5f) - 32768); // round to nearest
+    }
+
+    // triangular dither in LSB, the sum of the two halves of one random word
+    float nextDither() {
+        uint32_t bits = static_cast<uint32_t>(ditherRandom.nextInt());
+        return (static_cast<int16_t>(bits) + static_cast<int16_t>(bits >> 16)) * (1.0f / 65536.0f);
+    }
+
+public:
+    NoiseRandom& random() { return ditherRandom; }
+
+    void setDither(bool enabled) { dither = enabled; }
+
+    bool getDither() const { return dither; }
+
+    // mono block, the sample is written to both channels
+    void convert(const float* in, Frame* out, int32_t frameCount) {
+        if (dither) {
+            for (int32_t i = 0; i < frameCount; i++) {
+                out[i] = Frame(toPcm(in[i] + nextDither() * (1.0f / 32767.0f)));
+            }
+            return;
+        }
+        for (int32_t i = 0; i < frameCount; i++) {
+            out[i] = Frame(toPcm(in[i]));
+        }
+    }
+
+    // stereo block from separate channel buffers
+    void convert(const float* left, const float* right, Frame* out, int32_t frameCount) {
+        if (dither) {
+            for (int32_t i = 0; i < frameCount; i++) {
+                out[i] = Frame(toPcm(left[i] + nextDither() * (1.0f / 32767.0f)),
+                               toPcm(right[i] + nextDither() * (1.0f / 32767.0f)));
+            }
+            return;
+        }
+        for (int32_t i = 0; i < frameCount; i++) {
+            out[i] = Frame(toPcm(left[i]), toPcm(right[i]));
+        }
+    }
+};
+
+PcmConverter pcmConverter;
+
+// render a float generator into frames through the conversion kernel, in stack-sized chunks
+template <typename Generator>
+void render_pcm(Generator& generator, Frame* data, int32_t frameCount) {
+    float block[PCM_CHUNK_FRAMES];
+    for (int32_t offset = 0; offset < frameCount; offset += PCM_CHUNK_FRAMES) {
+        int32_t count = frameCount - offset < PCM_CHUNK_FRAMES ? frameCount - offset : PCM_CHUNK_FRAMES;
+        generator.renderBlock(block, count);
+        pcmConverter.convert(block, data + offset, count);
+    }
+}
+
+// stereo version, "left" renders the left channel and "right" the right one
+template <typename Generator>
+void render_pcm(Generator& left, Generator& right, Frame* data, int32_t frameCount) {
+    float blockLeft[PCM_CHUNK_FRAMES];
+    float blockRight[PCM_CHUNK_FRAMES];
+    for (int32_t offset = 0; offset < frameCount; offset += PCM_CHUNK_FRAMES) {
+        int32_t count = frameCount - offset < PCM_CHUNK_FRAMES ? frameCount - offset : PCM_CHUNK_FRAMES;
+        left.renderBlock(blockLeft, blockRight, count, right);
+        pcmConverter.convert(blockLeft, blockRight, data + offset, count);
+    }
+}
+
+#endif
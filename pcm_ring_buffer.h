@@ -0,0 +1,83 @@
+#ifndef PCM_RING_BUFFER_H
+#define PCM_RING_BUFFER_H
+
+#include <atomic>
+#include <cstring>
+#include <BluetoothA2DPSource.h>
+
+// lock-free single-producer/single-consumer ring of PCM frames.
+// head is only written by the producer and tail only by the consumer, both are
+// free-running counters so full and empty never need a spare slot.
+template <uint32_t Capacity>
+class PcmRingBuffer {
+private:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static const uint32_t mask = Capacity - 1;
+
+    Frame frames[Capacity];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> underruns{0}; // reads that had to be padded with silence
+
+public:
+    uint32_t capacity() const { return Capacity; }
+
+    // frames ready for the consumer
+    uint32_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    // free frames for the producer
+    uint32_t space() const { return Capacity - available(); }
+
+    // producer: contiguous free region of at most count frames, count is updated to its size
+    Frame* writeRegion(int32_t& count) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t free = Capacity - (h - tail.load(std::memory_order_acquire));
+        uint32_t contiguous = Capacity - (h & mask);
+        if (free > contiguous) free = contiguous;
+        if (static_cast<uint32_t>(count) > free) count = static_cast<int32_t>(free);
+        return &frames[h & mask];
+    }
+
+    // producer: publish frames rendered into writeRegion
+    void commit(int32_t count) {
+        head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // producer: copy frames in, returns how many fit. The producer task does not
+    // use it, it renders into writeRegion and waits while the ring is full.
+    int32_t write(const Frame* data, int32_t count) {
+        int32_t written = 0;
+        while (written < count) {
+            int32_t chunk = count - written;
+            Frame* region = writeRegion(chunk);
+            if (chunk == 0) break;
+            memcpy(region, data + written, chunk * sizeof(Frame));
+            commit(chunk);
+            written += chunk;
+        }
+        return written;
+    }
+
+    // consumer: always fills count frames, pads with silence and counts an underrun when short
+    int32_t read(Frame* data, int32_t count) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t ready = head.load(std::memory_order_acquire) - t;
+        uint32_t n = static_cast<uint32_t>(count) < ready ? static_cast<uint32_t>(count) : ready;
+        uint32_t first = Capacity - (t & mask);
+        if (first > n) first = n;
+        memcpy(data, &frames[t & mask], first * sizeof(Frame));
+        memcpy(data + first, &frames[0], (n - first) * sizeof(Frame));
+        tail.store(t + n, std::memory_order_release);
+        if (n < static_cast<uint32_t>(count)) {
+            for (int32_t i = static_cast<int32_t>(n); i < count; i++) data[i] = Frame(0);
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        return static_cast<int32_t>(n);
+    }
+
+    uint32_t getUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+};
+
+#endif
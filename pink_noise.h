@@ -1,74 +1,453 @@
 #ifndef PINK_NOISE_H
 #define PINK_NOISE_H
 
-// pink noise generator parameters
-const int NUM_PINK_BINS = 16;
-float pink_bins[NUM_PINK_BINS] = {0};
-int pink_index = 0;
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "constexpr_math.h"
+#include "noise_random.h"
+#include "pcm_convert.h"
+#include "colored_noise.h"
+
+// fixed-point helpers: coefficients are Q31, products are shifted back to the operand's format
+constexpr int32_t q31(double value) {
+    return static_cast<int32_t>(value * 2147483648.0 + (value < 0 ? -0.5 : 0.5));
+}
+
+inline int32_t q31_mul(int32_t value, int32_t coefficient) {
+    return static_cast<int32_t>((static_cast<int64_t>(value) * coefficient) >> 31);
+}
+
+// Paul Kellet's refined pink filter, published for 44.1 kHz. The five real poles
+// keep their corner frequencies at any rate and each input weight is scaled with
+// (1 - pole), so every section keeps its DC gain and its level relative to the
+// white taps. The negative pole and the delayed tap shape the top octave
+// relative to Nyquist and are used as they are.
+constexpr double KELLET_CORNER_HZ[5] = {8.005919850852832, 47.04243361944784, 221.02458400241505, 1005.7364983532842, 4196.058280056916};
+constexpr double KELLET_POLE_44K[5] = {0.99886, 0.99332, 0.96900, 0.86650, 0.55000};
+constexpr double KELLET_INPUT_44K[5] = {0.0555179, 0.0750759, 0.1538520, 0.3104856, 0.5329522};
 
-// generate random number between -1 and 1
-float random_float() {
-    return ((float)rand() / RAND_MAX) * 2.0f - 1.0f; // white noise
+// lane k of the filter, lanes 6 and 7 are zero padding
+constexpr double kellet_pole(int k, double sampleRate) {
+    return k < 5 ? one_pole(KELLET_CORNER_HZ[k], sampleRate) : (k == 5 ? -0.76160 : 0.0);
 }
 
-// generate pink noise sample
-float generate_pink_noise() {
-    float white = random_float();
-    pink_bins[pink_index] = white;
-    
-    float pink = 0;
-    int index = pink_index;
-    
-    // calculate pink noise
-    for (int i = 0; i < NUM_PINK_BINS; i++) {
-        pink += pink_bins[index];
-        index = (index - 1 + NUM_PINK_BINS) % NUM_PINK_BINS;
-    }
-    
-    pink_index = (pink_index + 1) % NUM_PINK_BINS;
-    pink = pink / NUM_PINK_BINS;
-    
-    return pink;
+constexpr double kellet_input(int k, double sampleRate) {
+    return k < 5 ? KELLET_INPUT_44K[k] * (1.0 - kellet_pole(k, sampleRate)) / (1.0 - KELLET_POLE_44K[k]) : (k == 5 ? -0.0168980 : 0.0);
 }
 
-#define NUM_RANDOMS 16 // size of random value array for pink noise
+// brown noise step: the random walk's level per second grows with the number of
+// steps, so the step is scaled by 1/sqrt(rate) to match 0.05 at 44.1 kHz
+constexpr double brown_step(double sampleRate) {
+    return 0.05 * constexpr_sqrt(44100.0 / sampleRate);
+}
+
+// pink noise generator parameters
+const int NUM_PINK_BINS = 16;
+
+// cursor generator: averages the last NUM_PINK_BINS white samples
+class PinkNoiseCursor {
+private:
+    float bins[NUM_PINK_BINS] = {0};
+    int32_t binsQ15[NUM_PINK_BINS] = {0};
+    int index = 0;
+    NoiseRandom rng;
+
+public:
+    NoiseRandom& random() { return rng; }
+
+    // clear the filter history, the random stream continues
+    void reset() {
+        for (int i = 0; i < NUM_PINK_BINS; i++) {
+            bins[i] = 0;
+            binsQ15[i] = 0;
+        }
+        index = 0;
+    }
+
+    // generate pink noise sample
+    float generateSample() {
+        float white = rng.nextFloat();
+        bins[index] = white;
+
+        float pink = 0;
+        int cursor = index;
+
+        // calculate pink noise
+        for (int i = 0; i < NUM_PINK_BINS; i++) {
+            pink += bins[cursor];
+            cursor = (cursor - 1 + NUM_PINK_BINS) % NUM_PINK_BINS;
+        }
+
+        index = (index + 1) % NUM_PINK_BINS;
+        return pink / NUM_PINK_BINS;
+    }
+
+    // integer version of generateSample, returns Q15
+    int32_t generateSampleQ15() {
+        binsQ15[index] = rng.nextInt() >> 16;
+
+        int32_t pink = 0;
+        int cursor = index;
+        for (int i = 0; i < NUM_PINK_BINS; i++) {
+            pink += binsQ15[cursor];
+            cursor = (cursor - 1 + NUM_PINK_BINS) % NUM_PINK_BINS;
+        }
 
-// Paul Kellet chatgpt
+        index = (index + 1) % NUM_PINK_BINS;
+        return pink / NUM_PINK_BINS;
+    }
+
+    // render a block of float samples, the cursor is played at half level
+    void renderBlock(float* out, int32_t frameCount) {
+        for (int32_t i = 0; i < frameCount; i++) {
+            out[i] = generateSample() * 0.5f;
+        }
+    }
+
+    void renderBlock(float* left, float* rightOut, int32_t frameCount, PinkNoiseCursor& right) {
+        for (int32_t i = 0; i < frameCount; i++) {
+            left[i] = generateSample() * 0.5f;
+            rightOut[i] = right.generateSample() * 0.5f;
+        }
+    }
+
+#if NOISE_FIXED_POINT
+    // render a block of mono frames
+    void renderBlock(Frame* data, int32_t frameCount) {
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(generateSampleQ15() >> 1);
+        }
+    }
+
+    // render a block of stereo frames, this generator is the left channel
+    void renderBlock(Frame* data, int32_t frameCount, PinkNoiseCursor& right) {
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(generateSampleQ15() >> 1, right.generateSampleQ15() >> 1);
+        }
+    }
+#else
+    void renderBlock(Frame* data, int32_t frameCount) { render_pcm(*this, data, frameCount); }
+
+    void renderBlock(Frame* data, int32_t frameCount, PinkNoiseCursor& right) { render_pcm(*this, right, data, frameCount); }
+#endif
+};
+
+// Paul Kellet's refined pink filter: six one-pole sections plus a one-sample
+// delayed white tap, within +/-0.05 dB of -3 dB/octave above 9.2 Hz at 44.1 and
+// 48 kHz. Coefficients are designed for SampleRate by the compiler. Sections
+// are stored as lanes so every pole is updated by the same straight-line code
+// and the sum is a fixed tree, both of which the compiler can vectorize. Lanes
+// 6 and 7 are zero padding.
+template <uint32_t SampleRate = AUDIO_SAMPLE_RATE>
 class PinkNoiseFilterV2 {
 private:
-    float coefficients[7] = {0.99765f, 0.96300f, 0.57000f}; // filter parameters
-    float states[7] = {0};                                  // filter states
-    float white;                                            // white noise input
+    static const int LANES = 8;
+    static constexpr float poles[LANES] = {
+        static_cast<float>(kellet_pole(0, SampleRate)), static_cast<float>(kellet_pole(1, SampleRate)),
+        static_cast<float>(kellet_pole(2, SampleRate)), static_cast<float>(kellet_pole(3, SampleRate)),
+        static_cast<float>(kellet_pole(4, SampleRate)), static_cast<float>(kellet_pole(5, SampleRate)), 0.0f, 0.0f};
+    static constexpr float inputs[LANES] = {
+        static_cast<float>(kellet_input(0, SampleRate)), static_cast<float>(kellet_input(1, SampleRate)),
+        static_cast<float>(kellet_input(2, SampleRate)), static_cast<float>(kellet_input(3, SampleRate)),
+        static_cast<float>(kellet_input(4, SampleRate)), static_cast<float>(kellet_input(5, SampleRate)), 0.0f, 0.0f};
+    static constexpr float directGain = 0.5362f;   // undelayed white tap
+    static constexpr float delayedGain = 0.115926f; // white tap delayed by one sample
+    static constexpr float outputGain = 0.11f;      // brings the output to roughly +/-1
+    float states[LANES] = {0};
+    float delayed = 0.0f;
+    NoiseRandom rng;
+
+    // one filter step on caller-owned state, shared by generateSample and renderBlock
+    float step(float* s, float& d, float white) const {
+        for (int k = 0; k < LANES; k++) {
+            s[k] = poles[k] * s[k] + inputs[k] * white;
+        }
+        float sum = ((s[0] + s[4]) + (s[1] + s[5])) + ((s[2] + s[6]) + (s[3] + s[7]));
+        float pink = sum + white * directGain + d;
+        d = white * delayedGain;
+        return pink * outputGain;
+    }
 
 public:
+    NoiseRandom& random() { return rng; }
+
+    // clear the filter states, the random stream continues
+    void reset() {
+        for (int k = 0; k < LANES; k++) states[k] = 0.0f;
+        delayed = 0.0f;
+    }
+
     float generateSample() {
-        white = random_float();
-        // filter update
-        states[0] = coefficients[0] * (states[0] + white);
-        states[1] = coefficients[1] * (states[1] + white);
-        states[2] = coefficients[2] * (states[2] + white);
-        states[3] = white * 0.1848f; // low frequency weighting
-        return (states[0] + states[1] + states[2] + states[3]) * 0.1848f; // adjust volume
+        return step(states, delayed, rng.nextFloat());
+    }
+
+    // render a block of float samples, filter states are kept in locals for the whole block
+    void renderBlock(float* out, int32_t frameCount) {
+        float s[LANES];
+        for (int k = 0; k < LANES; k++) s[k] = states[k];
+        float d = delayed;
+        for (int32_t i = 0; i < frameCount; i++) {
+            out[i] = step(s, d, rng.nextFloat());
+        }
+        for (int k = 0; k < LANES; k++) states[k] = s[k];
+        delayed = d;
     }
+
+    // stereo version, this filter is the left channel; both channels are
+    // stepped in the same pass so their lanes are updated together
+    void renderBlock(float* left, float* rightOut, int32_t frameCount, PinkNoiseFilterV2& right) {
+        float l[LANES], r[LANES];
+        for (int k = 0; k < LANES; k++) { l[k] = states[k]; r[k] = right.states[k]; }
+        float dl = delayed, dr = right.delayed;
+        for (int32_t i = 0; i < frameCount; i++) {
+            left[i] = step(l, dl, rng.nextFloat());
+            rightOut[i] = step(r, dr, right.rng.nextFloat());
+        }
+        for (int k = 0; k < LANES; k++) { states[k] = l[k]; right.states[k] = r[k]; }
+        delayed = dl;
+        right.delayed = dr;
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) { render_pcm(*this, data, frameCount); }
+
+    void renderBlock(Frame* data, int32_t frameCount, PinkNoiseFilterV2& right) { render_pcm(*this, right, data, frameCount); }
 };
 
 // brown noise generation (implemented by integrating white noise)
+template <uint32_t SampleRate = AUDIO_SAMPLE_RATE>
 class BrownNoiseGenerator {
 private:
     float lastValue = 0.0f; // save previous sample value
     const float limit = 1.0f;
+    static constexpr float stepSize = static_cast<float>(brown_step(SampleRate));
+    NoiseRandom rng;
 
 public:
+    NoiseRandom& random() { return rng; }
+
+    void reset() { lastValue = 0.0f; }
+
     float generateSample() {
-        float white = random_float();
-        lastValue += white * 0.05f;
+        float white = rng.nextFloat();
+        lastValue += white * stepSize;
         if (lastValue > limit) lastValue = limit;
         if (lastValue < -limit) lastValue = -limit;
         return lastValue;
     }
+
+    // render a block of float samples
+    void renderBlock(float* out, int32_t frameCount) {
+        float value = lastValue;
+        for (int32_t i = 0; i < frameCount; i++) {
+            value += rng.nextFloat() * stepSize;
+            value = value > limit ? limit : (value < -limit ? -limit : value);
+            out[i] = value;
+        }
+        lastValue = value;
+    }
+
+    // stereo version, this generator is the left channel
+    void renderBlock(float* left, float* rightOut, int32_t frameCount, BrownNoiseGenerator& right) {
+        float l = lastValue, r = right.lastValue;
+        for (int32_t i = 0; i < frameCount; i++) {
+            l += rng.nextFloat() * stepSize;
+            r += right.rng.nextFloat() * stepSize;
+            l = l > limit ? limit : (l < -limit ? -limit : l);
+            r = r > limit ? limit : (r < -limit ? -limit : r);
+            left[i] = l;
+            rightOut[i] = r;
+        }
+        lastValue = l;
+        right.lastValue = r;
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) { render_pcm(*this, data, frameCount); }
+
+    void renderBlock(Frame* data, int32_t frameCount, BrownNoiseGenerator& right) { render_pcm(*this, right, data, frameCount); }
 };
 
-PinkNoiseFilterV2 pinkNoiseFilterV2;
-BrownNoiseGenerator brownNoiseGenerator;
+// integer version of PinkNoiseFilterV2, produces PCM without touching the FPU
+template <uint32_t SampleRate = AUDIO_SAMPLE_RATE>
+class PinkNoiseFilterFixed {
+private:
+    static const int LANES = 8;
+    static const int STATE_BITS = 24; // states are Q24, the slowest pole has a DC gain of ~49 and must fit in int32
+    static constexpr int32_t poles[LANES] = {
+        q31(kellet_pole(0, SampleRate)), q31(kellet_pole(1, SampleRate)), q31(kellet_pole(2, SampleRate)),
+        q31(kellet_pole(3, SampleRate)), q31(kellet_pole(4, SampleRate)), q31(kellet_pole(5, SampleRate)), 0, 0};
+    static constexpr int32_t inputs[LANES] = {
+        q31(kellet_input(0, SampleRate)), q31(kellet_input(1, SampleRate)), q31(kellet_input(2, SampleRate)),
+        q31(kellet_input(3, SampleRate)), q31(kellet_input(4, SampleRate)), q31(kellet_input(5, SampleRate)), 0, 0};
+    static constexpr int32_t directGain = q31(0.5362);
+    static constexpr int32_t delayedGain = q31(0.115926);
+    static constexpr int32_t outputGain = q31(0.11);
+    int32_t states[LANES] = {0};
+    int32_t delayed = 0;
+    NoiseRandom rng;
+
+    // one filter step in Q24, returns Q15
+    int32_t step(int32_t* s, int32_t& d, int32_t white) const {
+        for (int k = 0; k < LANES; k++) {
+            s[k] = q31_mul(s[k], poles[k]) + q31_mul(white, inputs[k]);
+        }
+        int32_t sum = ((s[0] + s[4]) + (s[1] + s[5])) + ((s[2] + s[6]) + (s[3] + s[7]));
+        int32_t pink = sum + q31_mul(white, directGain) + d;
+        d = q31_mul(white, delayedGain);
+        return q31_mul(pink, outputGain) >> (STATE_BITS - 15);
+    }
+
+public:
+    NoiseRandom& random() { return rng; }
+
+    void reset() {
+        for (int k = 0; k < LANES; k++) states[k] = 0;
+        delayed = 0;
+    }
+
+    // next sample in Q15
+    int32_t generateSample() {
+        return step(states, delayed, rng.nextInt() >> (31 - STATE_BITS));
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) {
+        int32_t s[LANES];
+        for (int k = 0; k < LANES; k++) s[k] = states[k];
+        int32_t d = delayed;
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(saturate_pcm(step(s, d, rng.nextInt() >> (31 - STATE_BITS))));
+        }
+        for (int k = 0; k < LANES; k++) states[k] = s[k];
+        delayed = d;
+    }
+
+    // render a block of stereo frames, this filter is the left channel
+    void renderBlock(Frame* data, int32_t frameCount, PinkNoiseFilterFixed& right) {
+        int32_t l[LANES], r[LANES];
+        for (int k = 0; k < LANES; k++) { l[k] = states[k]; r[k] = right.states[k]; }
+        int32_t dl = delayed, dr = right.delayed;
+        for (int32_t i = 0; i < frameCount; i++) {
+            int32_t left = step(l, dl, rng.nextInt() >> (31 - STATE_BITS));
+            int32_t rightSample = step(r, dr, right.rng.nextInt() >> (31 - STATE_BITS));
+            data[i] = Frame(saturate_pcm(left), saturate_pcm(rightSample));
+        }
+        for (int k = 0; k < LANES; k++) { states[k] = l[k]; right.states[k] = r[k]; }
+        delayed = dl;
+        right.delayed = dr;
+    }
+};
+
+// integer version of BrownNoiseGenerator, the integrator runs in Q30
+template <uint32_t SampleRate = AUDIO_SAMPLE_RATE>
+class BrownNoiseGeneratorFixed {
+private:
+    static const int32_t limit = (1 << 30) - (1 << 15); // just below 1.0 so the Q15 output fits int16
+    static constexpr int32_t step = q31(brown_step(SampleRate));
+    int32_t lastValue = 0;
+    NoiseRandom rng;
+
+public:
+    NoiseRandom& random() { return rng; }
+
+    void reset() { lastValue = 0; }
+
+    // next sample in Q15
+    int32_t generateSample() {
+        lastValue += q31_mul(rng.nextInt(), step) >> 1;
+        if (lastValue > limit) lastValue = limit;
+        if (lastValue < -limit) lastValue = -limit;
+        return lastValue >> 15;
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) {
+        int32_t value = lastValue;
+        for (int32_t i = 0; i < frameCount; i++) {
+            value += q31_mul(rng.nextInt(), step) >> 1;
+            value = value > limit ? limit : (value < -limit ? -limit : value);
+            data[i] = Frame(value >> 15);
+        }
+        lastValue = value;
+    }
+
+    // render a block of stereo frames, this generator is the left channel
+    void renderBlock(Frame* data, int32_t frameCount, BrownNoiseGeneratorFixed& right) {
+        int32_t l = lastValue, r = right.lastValue;
+        for (int32_t i = 0; i < frameCount; i++) {
+            l += q31_mul(rng.nextInt(), step) >> 1;
+            r += q31_mul(right.rng.nextInt(), step) >> 1;
+            l = l > limit ? limit : (l < -limit ? -limit : l);
+            r = r > limit ? limit : (r < -limit ? -limit : r);
+            data[i] = Frame(l >> 15, r >> 15);
+        }
+        lastValue = l;
+        right.lastValue = r;
+    }
+};
+
+// Voss-McCartney pink noise: row k is refreshed every 2^k samples, picked by the
+// trailing zeros of a counter, and a running sum keeps the cost O(1) per sample.
+// Integer only, so it is used unchanged in both float and fixed-point builds.
+template <int Octaves = 16>
+class VossMcCartneyPinkNoise {
+private:
+    static_assert(Octaves > 0 && Octaves < 31, "Octaves must fit the 32-bit row counter");
+    static const uint32_t mask = (1u << Octaves) - 1;
+    static const int32_t gain = (32768 + (Octaves + 2) / 2) / (Octaves + 2); // Q15 1/(rows + white)
+    int32_t rows[Octaves + 1] = {0}; // rows[Octaves] is refreshed when the counter wraps
+    int32_t runningSum = 0;
+    uint32_t counter = 0;
+    NoiseRandom rng;
+
+public:
+    NoiseRandom& random() { return rng; }
+
+    void reset() {
+        for (int k = 0; k <= Octaves; k++) rows[k] = 0;
+        runningSum = 0;
+        counter = 0;
+    }
+
+    // next sample in Q15
+    int32_t generateSample() {
+        counter = (counter + 1) & mask;
+        int row = __builtin_ctz(counter | (1u << Octaves));
+        int32_t value = rng.nextInt() >> 16;
+        runningSum += value - rows[row];
+        rows[row] = value;
+        int32_t white = rng.nextInt() >> 16;
+        return ((runningSum + white) * gain) >> 15;
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) {
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(saturate_pcm(generateSample()));
+        }
+    }
+
+    // render a block of stereo frames, this generator is the left channel
+    void renderBlock(Frame* data, int32_t frameCount, VossMcCartneyPinkNoise& right) {
+        for (int32_t i = 0; i < frameCount; i++) {
+            data[i] = Frame(saturate_pcm(generateSample()), saturate_pcm(right.generateSample()));
+        }
+    }
+};
+
+#if NOISE_FIXED_POINT
+typedef PinkNoiseFilterFixed<AUDIO_SAMPLE_RATE> PinkNoiseFilter;
+typedef BrownNoiseGeneratorFixed<AUDIO_SAMPLE_RATE> BrownNoise;
+#else
+typedef PinkNoiseFilterV2<AUDIO_SAMPLE_RATE> PinkNoiseFilter;
+typedef BrownNoiseGenerator<AUDIO_SAMPLE_RATE> BrownNoise;
+#endif
+
+// the plain instances render mono and the left channel, *Right instances the
+// right channel in stereo mode, every instance has its own state and random stream
+PinkNoiseFilter pinkNoiseFilterV2;
+PinkNoiseFilter pinkNoiseFilterV2Right;
+BrownNoise brownNoiseGenerator;
+BrownNoise brownNoiseGeneratorRight;
+PinkNoiseCursor pinkNoiseCursor;
+PinkNoiseCursor pinkNoiseCursorRight;
+VossMcCartneyPinkNoise<> vossPinkNoise;
+VossMcCartneyPinkNoise<> vossPinkNoiseRight;
 
-#endif 
\ No newline at end of file
+#endif
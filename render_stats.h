@@ -0,0 +1,174 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <atomic>
+#include <Arduino.h>
+#include "config.h"
+#ifdef ESP_PLATFORM
+#include <esp_cpu.h>
+#else
+#include <chrono>
+#endif
+
+#ifndef ESP_PLATFORM
+// host builds: a test can drive the ticks itself, in nanoseconds, instead of the steady clock
+inline uint32_t (*hostStatsClock)() = nullptr;
+#endif
+
+// tick source for the instrumentation: the CPU cycle counter on the ESP32, a
+// nanosecond clock on host builds. Only differences are used, so the 32-bit wrap is harmless.
+inline uint32_t stats_ticks() {
+#ifdef ESP_PLATFORM
+    return static_cast<uint32_t>(esp_cpu_get_cycle_count());
+#else
+    if (hostStatsClock) return hostStatsClock();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline uint32_t stats_ticks_per_us() {
+#ifdef ESP_PLATFORM
+    return getCpuFrequencyMhz();
+#else
+    return 1000;
+#endif
+}
+
+// copy of the counters for reporting
+struct RenderStatsSnapshot {
+    static const int BUCKETS = 12;
+    uint32_t calls;
+    uint32_t frames;
+    uint32_t minFrames;
+    uint32_t maxFrames;
+    uint32_t silentFrames;
+    uint32_t worstRenderUs;
+    uint32_t worstLoadPermille; // render time over the call's realtime budget
+    uint32_t maxJitterUs;
+    uint32_t meanJitterUs;
+    uint32_t synthesisUsPerSecond; // CPU time spent synthesizing one second of audio, mixer to PCM
+    uint32_t histogram[BUCKETS]; // calls by render time: bucket 0 is < 1 us, bucket k < 2^k us, the last is open
+};
+
+// timing of the A2DP callback. begin/end are called by the callback only, so
+// the counters have one writer and are plain relaxed atomics that any task can
+// read; silent frames may come from the producer task and are added atomically.
+// A reset is only requested by readers and carried out by the writer.
+class RenderStats {
+private:
+    static const int BUCKETS = RenderStatsSnapshot::BUCKETS;
+    std::atomic<uint32_t> calls{0};
+    std::atomic<uint32_t> frames{0};
+    std::atomic<uint32_t> minFrames{UINT32_MAX};
+    std::atomic<uint32_t> maxFrames{0};
+    std::atomic<uint32_t> silentFrames{0};
+    std::atomic<uint32_t> worstRenderUs{0};
+    std::atomic<uint32_t> worstLoadPermille{0};
+    std::atomic<uint32_t> maxJitterUs{0};
+    std::atomic<uint32_t> jitterSumUs{0};
+    std::atomic<uint32_t> histogram[BUCKETS] = {};
+    std::atomic<uint32_t> synthesisUs{0};
+    std::atomic<uint32_t> synthesisFrames{0};
+    std::atomic<bool> resetRequested{false};
+    std::atomic<bool> synthesisResetRequested{false}; // separate, the synthesis counters have their own writer
+    uint32_t lastStart = 0; // writer only
+    uint32_t lastFrames = 0;
+    uint32_t synthesisTicks = 0; // synthesis writer only
+
+    static void raise(std::atomic<uint32_t>& counter, uint32_t value) {
+        if (value > counter.load(std::memory_order_relaxed)) counter.store(value, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        calls.store(0, std::memory_order_relaxed);
+        frames.store(0, std::memory_order_relaxed);
+        minFrames.store(UINT32_MAX, std::memory_order_relaxed);
+        maxFrames.store(0, std::memory_order_relaxed);
+        silentFrames.store(0, std::memory_order_relaxed);
+        worstRenderUs.store(0, std::memory_order_relaxed);
+        worstLoadPermille.store(0, std::memory_order_relaxed);
+        maxJitterUs.store(0, std::memory_order_relaxed);
+        jitterSumUs.store(0, std::memory_order_relaxed);
+        for (int k = 0; k < BUCKETS; k++) histogram[k].store(0, std::memory_order_relaxed);
+        lastFrames = 0;
+    }
+
+public:
+    uint32_t begin() { return stats_ticks(); }
+
+    void end(uint32_t start, int32_t frameCount) {
+        const uint32_t now = stats_ticks();
+        const uint32_t ticksPerUs = stats_ticks_per_us();
+        if (resetRequested.exchange(false, std::memory_order_relaxed)) clear();
+
+        const uint32_t renderUs = (now - start) / ticksPerUs;
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && renderUs >= (1u << bucket)) bucket++;
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+        raise(worstRenderUs, renderUs);
+        if (frameCount > 0) {
+            raise(worstLoadPermille, static_cast<uint32_t>(static_cast<uint64_t>(renderUs) * AUDIO_SAMPLE_RATE / 1000 / frameCount));
+        }
+
+        // jitter: how far this call started from where the previous call's frames ran out
+        if (lastFrames) {
+            const uint32_t intervalUs = (start - lastStart) / ticksPerUs;
+            const uint32_t expectedUs = static_cast<uint32_t>(static_cast<uint64_t>(lastFrames) * 1000000 / AUDIO_SAMPLE_RATE);
+            const uint32_t jitterUs = intervalUs > expectedUs ? intervalUs - expectedUs : expectedUs - intervalUs;
+            raise(maxJitterUs, jitterUs);
+            jitterSumUs.fetch_add(jitterUs, std::memory_order_relaxed);
+        }
+        lastStart = start;
+        lastFrames = static_cast<uint32_t>(frameCount);
+
+        calls.fetch_add(1, std::memory_order_relaxed);
+        frames.fetch_add(static_cast<uint32_t>(frameCount), std::memory_order_relaxed);
+        if (static_cast<uint32_t>(frameCount) < minFrames.load(std::memory_order_relaxed)) minFrames.store(frameCount, std::memory_order_relaxed);
+        raise(maxFrames, static_cast<uint32_t>(frameCount));
+    }
+
+    // time of one synthesized block. With the producer task this runs there, not in
+    // the callback, so it is what playing a precomputed loop saves against synthesis.
+    void addSynthesis(uint32_t start, int32_t frameCount) {
+        const uint32_t ticksPerUs = stats_ticks_per_us();
+        const uint32_t ticks = stats_ticks() - start + synthesisTicks; // the sub-us remainder carries over, short blocks add up
+        const uint32_t us = ticks / ticksPerUs;
+        synthesisTicks = ticks % ticksPerUs;
+        if (synthesisResetRequested.exchange(false, std::memory_order_relaxed)) {
+            synthesisUs.store(0, std::memory_order_relaxed);
+            synthesisFrames.store(0, std::memory_order_relaxed);
+        }
+        synthesisUs.fetch_add(us, std::memory_order_relaxed);
+        synthesisFrames.fetch_add(static_cast<uint32_t>(frameCount), std::memory_order_relaxed);
+    }
+
+    // frames rendered as silence because playback is muted
+    void addSilentFrames(int32_t count) { silentFrames.fetch_add(static_cast<uint32_t>(count), std::memory_order_relaxed); }
+
+    // the counters are cleared by the next callback
+    void reset() {
+        resetRequested.store(true, std::memory_order_relaxed);
+        synthesisResetRequested.store(true, std::memory_order_relaxed);
+    }
+
+    RenderStatsSnapshot snapshot() const {
+        RenderStatsSnapshot s;
+        s.calls = calls.load(std::memory_order_relaxed);
+        s.frames = frames.load(std::memory_order_relaxed);
+        s.minFrames = s.calls ? minFrames.load(std::memory_order_relaxed) : 0;
+        s.maxFrames = maxFrames.load(std::memory_order_relaxed);
+        s.silentFrames = silentFrames.load(std::memory_order_relaxed);
+        s.worstRenderUs = worstRenderUs.load(std::memory_order_relaxed);
+        s.worstLoadPermille = worstLoadPermille.load(std::memory_order_relaxed);
+        s.maxJitterUs = maxJitterUs.load(std::memory_order_relaxed);
+        s.meanJitterUs = s.calls > 1 ? jitterSumUs.load(std::memory_order_relaxed) / (s.calls - 1) : 0;
+        const uint32_t synthesized = synthesisFrames.load(std::memory_order_relaxed);
+        s.synthesisUsPerSecond = synthesized ? static_cast<uint32_t>(static_cast<uint64_t>(synthesisUs.load(std::memory_order_relaxed)) *
+                                                                     AUDIO_SAMPLE_RATE / synthesized) : 0;
+        for (int k = 0; k < BUCKETS; k++) s.histogram[k] = histogram[k].load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SINE_TABLE_H
+#define SINE_TABLE_H
+
+#include <stdint.h>
+#include "constexpr_math.h"
+
+// one sine period in SIZE steps and a guard entry for the interpolation, generated by the compiler
+struct SineTable {
+    static const int BITS = 8;
+    static const int SIZE = 1 << BITS;
+    float values[SIZE + 1];
+
+    constexpr SineTable() : values{} {
+        for (int i = 0; i <= SIZE; i++) {
+            values[i] = static_cast<float>(constexpr_sin(6.283185307179586 * i / SIZE));
+        }
+    }
+};
+
+constexpr SineTable sineTable;
+
+// sine of a 32-bit phase, 2^32 is one period. The top BITS index the table and
+// the rest interpolate linearly, the error stays below 1e-4 (-80 dB).
+inline float sine_lookup(uint32_t phase) {
+    const int shift = 32 - SineTable::BITS;
+    const uint32_t index = phase >> shift;
+    const float frac = static_cast<float>(phase & ((1u << shift) - 1)) * (1.0f / (1u << shift));
+    const float a = sineTable.values[index];
+    return a + (sineTable.values[index + 1] - a) * frac;
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef TONE_GENERATOR_H
+#define TONE_GENERATOR_H
+
+#include <BluetoothA2DPSource.h>
+#include "config.h"
+#include "pcm_convert.h"
+#include "sine_table.h"
+
+// binaural beat and isochronic tone generator. Each ear has its own integer phase
+// accumulator, so the carriers never drift and no sinf runs in the audio path.
+// Binaural mode plays carrier -/+ beat/2 on the left/right ear; isochronic mode
+// plays the carrier on both ears, pulsed on and off at the beat rate. The pulse
+// envelope is evaluated once every TONE_CONTROL_FRAMES frames and ramped linearly
+// in between. Output is always stereo.
+class ToneGenerator {
+public:
+    enum Mode { BINAURAL = 0, ISOCHRONIC = 1 };
+
+private:
+    uint32_t phaseLeft = 0;
+    uint32_t phaseRight = 0;
+    uint32_t pulsePhase = 0;
+    uint32_t stepLeft = 0;  // phase per frame
+    uint32_t stepRight = 0;
+    uint32_t pulseStep = 0; // pulse phase per control block
+    int mode = BINAURAL;
+    float carrierHz = 0.0f;
+    float beatHz = 0.0f;
+    float gain = 0.0f;      // envelope times level, render path only
+    float gainStep = 0.0f;
+    int32_t controlFrames = 0; // frames left in the current control block
+
+    static uint32_t phaseStep(float hz, uint32_t frames) {
+        return hz > 0.0f ? static_cast<uint32_t>(static_cast<double>(hz) * 4294967296.0 * frames / AUDIO_SAMPLE_RATE) : 0;
+    }
+
+    // isochronic pulse: on for the first half of the period, with raised-cosine edges of a tenth of it
+    static float pulseShape(uint32_t phase) {
+        const uint32_t edge = 0x1999999Au;
+        const uint32_t half = 0x80000000u;
+        if (phase >= half) return 0.0f;
+        if (phase >= edge && phase < half - edge) return 1.0f;
+        uint32_t ramp = phase < edge ? phase : half - phase;
+        float s = sine_lookup(static_cast<uint32_t>((static_cast<uint64_t>(ramp) << 30) / edge)); // quarter period
+        return s * s;
+    }
+
+    void nextControlBlock() {
+        float target = TONE_LEVEL;
+        if (mode == ISOCHRONIC) {
+            target *= pulseShape(pulsePhase);
+            pulsePhase += pulseStep;
+        }
+        gainStep = (target - gain) / TONE_CONTROL_FRAMES;
+        controlFrames = TONE_CONTROL_FRAMES;
+    }
+
+public:
+    ToneGenerator() { setTone(TONE_CARRIER_HZ, TONE_BEAT_HZ, TONE_MODE); }
+
+    // carrier 20..1500 Hz, beat 0..40 Hz and below 2x carrier, so the lower ear
+    // stays at TONE_MIN_EAR_HZ or above; NaN takes the lower bound
+    void setTone(float carrier, float beat, int newMode) {
+        if (!(carrier >= 20.0f)) carrier = 20.0f;
+        if (carrier > 1500.0f) carrier = 1500.0f;
+        if (!(beat >= 0.0f)) beat = 0.0f;
+        if (beat > 40.0f) beat = 40.0f;
+        if (beat > 2.0f * (carrier - TONE_MIN_EAR_HZ)) beat = 2.0f * (carrier - TONE_MIN_EAR_HZ);
+        carrierHz = carrier;
+        beatHz = beat;
+        mode = newMode == ISOCHRONIC ? ISOCHRONIC : BINAURAL;
+        if (mode == BINAURAL) {
+            stepLeft = phaseStep(carrier - beat * 0.5f, 1);
+            stepRight = phaseStep(carrier + beat * 0.5f, 1);
+        } else {
+            stepLeft = stepRight = phaseStep(carrier, 1);
+        }
+        pulseStep = phaseStep(beat, TONE_CONTROL_FRAMES);
+    }
+
+    float getCarrier() const { return carrierHz; }
+
+    float getBeat() const { return beatHz; }
+
+    int getMode() const { return mode; }
+
+    // restart both ears in phase, fading in from silence
+    void reset() {
+        phaseLeft = 0;
+        phaseRight = 0;
+        pulsePhase = 0;
+        gain = 0.0f;
+        controlFrames = 0;
+    }
+
+    void renderBlock(float* left, float* right, int32_t frameCount) {
+        const uint32_t stepL = stepLeft;
+        const uint32_t stepR = stepRight;
+        int32_t i = 0;
+        while (i < frameCount) {
+            if (controlFrames == 0) nextControlBlock();
+            int32_t count = frameCount - i < controlFrames ? frameCount - i : controlFrames;
+            controlFrames -= count;
+            for (const int32_t end = i + count; i < end; i++) {
+                gain += gainStep;
+                left[i] = sine_lookup(phaseLeft) * gain;
+                right[i] = sine_lookup(phaseRight) * gain;
+                phaseLeft += stepL;
+                phaseRight += stepR;
+            }
+        }
+    }
+
+    void renderBlock(Frame* data, int32_t frameCount) {
+        float blockLeft[PCM_CHUNK_FRAMES];
+        float blockRight[PCM_CHUNK_FRAMES];
+        for (int32_t offset = 0; offset < frameCount; offset += PCM_CHUNK_FRAMES) {
+            int32_t count = frameCount - offset < PCM_CHUNK_FRAMES ? frameCount - offset : PCM_CHUNK_FRAMES;
+            renderBlock(blockLeft, blockRight, count);
+            pcmConverter.convert(blockLeft, blockRight, data + offset, count);
+        }
+    }
+};
+
+ToneGenerator toneGenerator;
+
+// registry entry points, the tone ignores the mono setting since a binaural beat needs both ears
+void render_tone(Frame* data, int32_t frameCount, bool) { toneGenerator.renderBlock(data, frameCount); }
+
+void render_tone_float(float* left, float* right, int32_t frameCount, bool) { toneGenerator.renderBlock(left, right, frameCount); }
+
+void reset_tone() { toneGenerator.reset(); }
+
+#endif
@@ -0,0 +1,252 @@
+// Host benchmark for the noise generators and output stages, results as JSON.
+// The sketch headers are built against the stand-ins in tools/host.
+//
+//   bench_noise [seconds of audio per run] > bench.json
+//
+// Every registered algorithm is measured. Every case renders the same amount of audio in blocks of each size, RUNS
+// times; ns/sample and its variance are taken over the runs.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "adpcm.h"
+#include "audio_player.h"
+
+#define STRINGIFY2(x) #x
+#define STRINGIFY(x) STRINGIFY2(x)
+
+static const int RUNS = 15;
+static const int32_t BLOCK_SIZES[] = {32, 128, 256, 512};
+
+static double seconds = 0.5;
+static bool firstResult = true;
+static int dispatchedAlgorithm = 0; // read for every frame, as noiseAlgorithm was
+
+// time a block function over RUNS runs, each rendering "seconds" of audio
+template <typename Render>
+static void bench(const char* name, const char* channels, int32_t blockSize, Render render) {
+    const int32_t frames = static_cast<int32_t>(seconds * AUDIO_SAMPLE_RATE);
+    const int32_t blocks = (frames + blockSize - 1) / blockSize;
+    const double samples = static_cast<double>(blocks) * blockSize;
+    std::vector<double> nsPerSample(RUNS);
+
+    for (int32_t b = 0; b < blocks / 4 + 1; b++) render(blockSize); // warm up caches and filter states
+    for (int run = 0; run < RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t b = 0; b < blocks; b++) render(blockSize);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        nsPerSample[run] = std::chrono::duration<double, std::nano>(elapsed).count() / samples;
+    }
+
+    double mean = 0.0, variance = 0.0, best = nsPerSample[0];
+    for (double v : nsPerSample) {
+        mean += v;
+        if (v < best) best = v;
+    }
+    mean /= RUNS;
+    for (double v : nsPerSample) variance += (v - mean) * (v - mean);
+    variance /= RUNS - 1;
+
+    printf("%s    {\"name\": \"%s\", \"channels\": \"%s\", \"block\": %d, \"ns_per_sample\": %.3f, "
+           "\"ns_per_sample_min\": %.3f, \"variance\": %.5f, \"samples_per_sec\": %.0f}",
+           firstResult ? "" : ",\n", name, channels, blockSize, mean, best, variance, 1e9 / mean);
+    firstResult = false;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) seconds = atof(argv[1]);
+    if (seconds <= 0) seconds = 0.5;
+
+    seed_noise_generators();
+    AudioPlayer player;
+    noiseMixer.update(); // the default soundscape layers
+    static Frame frames[512];
+    static Frame other[512];
+    static float floats[512];
+    static float floatsRight[512];
+    static float scratchLeft[512];
+    static float scratchRight[512];
+    for (int32_t i = 0; i < 512; i++) {
+        floats[i] = pinkNoiseFilterV2Right.random().nextFloat();
+        floatsRight[i] = pinkNoiseFilterV2Right.random().nextFloat();
+    }
+
+    // accuracy of the tone generator's interpolated sine table over a full period
+    double sineError = 0.0;
+    for (uint32_t phase = 0; phase < 0xFFFF0000u; phase += 0x10000u) {
+        sineError = fmax(sineError, fabs(sine_lookup(phase) - sin(phase * (2.0 * M_PI / 4294967296.0))));
+    }
+
+    printf("{\n  \"sample_rate\": %d,\n  \"fixed_point\": %d,\n  \"random_engine\": \"%s\",\n  \"compiler\": \"%s\",\n"
+           "  \"sine_lut_max_error\": %.2e,\n  \"results\": [\n",
+           AUDIO_SAMPLE_RATE, NOISE_FIXED_POINT, STRINGIFY(NOISE_RANDOM_ENGINE), __VERSION__, sineError);
+
+    for (int32_t block : BLOCK_SIZES) {
+        for (int alg = 0; alg < NOISE_ALGORITHM_COUNT; alg++) {
+            player.setStereo(false);
+            bench(noiseAlgorithms[alg].name, "mono", block, [&](int32_t n) { AudioPlayer::renderAlgorithm(alg, frames, n); });
+            player.setStereo(true);
+            bench(noiseAlgorithms[alg].name, "stereo", block, [&](int32_t n) { AudioPlayer::renderAlgorithm(alg, frames, n); });
+        }
+        player.setStereo(false);
+
+        // the callback before block rendering: the algorithm switch, a generateSample() call and the cast
+        // for every frame. Compare with the "Pink filter v2", "Brown" and "Pink cursor" cases above.
+        static PinkNoiseFilterV2<> dispatchPink;
+        static BrownNoiseGenerator<> dispatchBrown;
+        static PinkNoiseCursor dispatchCursor;
+        const char* dispatchCases[] = {"per_sample_pink_filter_v2", "per_sample_brown", "per_sample_pink_cursor"};
+        for (int alg = 0; alg < 3; alg++) {
+            dispatchedAlgorithm = alg;
+            bench(dispatchCases[alg], "mono", block, [&](int32_t n) {
+                for (int32_t i = 0; i < n; i++) {
+                    float sample;
+                    switch (dispatchedAlgorithm) {
+                    case 0: sample = dispatchPink.generateSample(); break;
+                    case 1: sample = dispatchBrown.generateSample(); break;
+                    default: sample = dispatchCursor.generateSample() * 0.5f;
+                    }
+                    frames[i] = Frame(static_cast<int16_t>(sample * 32767));
+                }
+            });
+        }
+
+        // white noise engines, rand() as the generators used it before they had their own
+        BasicNoiseRandom<XorShift32> xorshift;
+        BasicNoiseRandom<Pcg32> pcg;
+        bench("random_xorshift32", "mono", block, [&](int32_t n) { xorshift.fillFloat(scratchLeft, n); });
+        bench("random_pcg32", "mono", block, [&](int32_t n) { pcg.fillFloat(scratchLeft, n); });
+        bench("random_libc_rand", "mono", block, [&](int32_t n) {
+            for (int32_t i = 0; i < n; i++) scratchLeft[i] = ((float)rand() / RAND_MAX) * 2.0f - 1.0f;
+        });
+
+        // the cast the conversion replaced, it neither saturates nor dithers
+        bench("pcm_cast", "mono", block, [&](int32_t n) {
+            for (int32_t i = 0; i < n; i++) frames[i] = Frame(static_cast<int16_t>(floats[i] * 32767));
+        });
+        bench("pcm_cast", "stereo", block, [&](int32_t n) {
+            for (int32_t i = 0; i < n; i++) frames[i] = Frame(static_cast<int16_t>(floats[i] * 32767), static_cast<int16_t>(floatsRight[i] * 32767));
+        });
+        pcmConverter.setDither(false);
+        bench("pcm_convert", "mono", block, [&](int32_t n) { pcmConverter.convert(floats, frames, n); });
+        bench("pcm_convert", "stereo", block, [&](int32_t n) { pcmConverter.convert(floats, floatsRight, frames, n); });
+        pcmConverter.setDither(true);
+        bench("pcm_convert_dither", "stereo", block, [&](int32_t n) { pcmConverter.convert(floats, floatsRight, frames, n); });
+        pcmConverter.setDither(PCM_DITHER);
+
+        // software gain: at unity, as before the stage existed, at a steady attenuation and while ramping
+        GainStage gain;
+        bench("gain_stage_unity", "stereo", block, [&](int32_t n) { gain.process(frames, n); });
+        gain.setAttenuation(3);
+        bench("gain_stage", "stereo", block, [&](int32_t n) { gain.process(frames, n); });
+        gain.setRampTime(60000, AUDIO_SAMPLE_RATE); // still ramping at the end of the case
+        bool down = true;
+        bench("gain_stage_ramp", "stereo", block, [&](int32_t n) {
+            gain.setAttenuation(down ? GainTable::SIZE : 0);
+            down = !down;
+            gain.process(frames, n);
+        });
+
+        // output EQ against the number of enabled sections, the per-section cost is the step between cases
+        Equalizer eq;
+        for (int sections = 0; sections <= EQ_BANDS; sections++) {
+            for (int i = 0; i < EQ_BANDS; i++) {
+                EqBand band = eq.getBand(i);
+                band.type = i < sections ? EqBand::PEAKING : EqBand::OFF;
+                band.db = 3.0f;
+                eq.setBand(i, band);
+            }
+            char name[32];
+            snprintf(name, sizeof(name), "eq_%d_sections", sections);
+            bench(name, "stereo", block, [&](int32_t n) { eq.process(frames, n); });
+        }
+
+        Crossfade fade;
+        fade.setDuration(60000, AUDIO_SAMPLE_RATE); // long enough to stay active for the whole case
+        fade.start();
+        bench("crossfade", "stereo", block, [&](int32_t n) { fade.mix(other, frames, n); });
+
+        // tone generator against a sinf reference driven by the same phase accumulators
+        toneGenerator.setTone(TONE_CARRIER_HZ, TONE_BEAT_HZ, ToneGenerator::BINAURAL);
+        bench("tone_lut", "stereo", block, [&](int32_t n) { toneGenerator.renderBlock(scratchLeft, scratchRight, n); });
+        const uint32_t stepLeft = static_cast<uint32_t>((TONE_CARRIER_HZ - TONE_BEAT_HZ * 0.5) * 4294967296.0 / AUDIO_SAMPLE_RATE);
+        const uint32_t stepRight = static_cast<uint32_t>((TONE_CARRIER_HZ + TONE_BEAT_HZ * 0.5) * 4294967296.0 / AUDIO_SAMPLE_RATE);
+        uint32_t phaseLeft = 0, phaseRight = 0;
+        bench("tone_sinf", "stereo", block, [&](int32_t n) {
+            for (int32_t i = 0; i < n; i++) {
+                scratchLeft[i] = sinf(static_cast<float>(phaseLeft) * (6.28318531f / 4294967296.0f)) * TONE_LEVEL;
+                scratchRight[i] = sinf(static_cast<float>(phaseRight) * (6.28318531f / 4294967296.0f)) * TONE_LEVEL;
+                phaseLeft += stepLeft;
+                phaseRight += stepRight;
+            }
+        });
+
+        // modulated soundscape with the modulators at the control rate and, for comparison, every sample
+        oceanWaves.setControlInterval(MODULATION_CONTROL_FRAMES);
+        bench("modulation_control_rate", "mono", block, [&](int32_t n) { oceanWaves.renderBlock(scratchLeft, scratchRight, n, false); });
+        bench("modulation_control_rate", "stereo", block, [&](int32_t n) { oceanWaves.renderBlock(scratchLeft, scratchRight, n, true); });
+        oceanWaves.setControlInterval(1);
+        bench("modulation_per_sample", "mono", block, [&](int32_t n) { oceanWaves.renderBlock(scratchLeft, scratchRight, n, false); });
+        bench("modulation_per_sample", "stereo", block, [&](int32_t n) { oceanWaves.renderBlock(scratchLeft, scratchRight, n, true); });
+        oceanWaves.setControlInterval(MODULATION_CONTROL_FRAMES);
+
+        // soundscape cost against the number of layers, idle layers (gain 0) must cost nothing.
+        // The default layers are put back afterwards, the "Soundscape" case of the next pass uses them.
+        const char* layerSources[] = {"Brown", "Pink filter v2", "Blue", "Custom slope"};
+        int savedSources[NoiseMixer::LAYERS];
+        float savedGains[NoiseMixer::LAYERS];
+        for (int i = 0; i < NoiseMixer::LAYERS; i++) {
+            savedSources[i] = player.getLayerAlgorithm(i);
+            savedGains[i] = player.getLayerGain(i);
+        }
+        for (int layers = 0; layers <= NoiseMixer::LAYERS; layers++) {
+            for (int i = 0; i < NoiseMixer::LAYERS; i++) {
+                int source = i < 4 ? find_noise_algorithm(layerSources[i]) : -1;
+                player.setLayer(i, source, i < layers ? 0.5f : 0.0f);
+            }
+            noiseMixer.update();
+            char name[32];
+            snprintf(name, sizeof(name), "mixer_%d_layers", layers);
+            bench(name, "mono", block, [&](int32_t n) { noiseMixer.render(frames, n, false); });
+            bench(name, "stereo", block, [&](int32_t n) { noiseMixer.render(frames, n, true); });
+        }
+        for (int i = 0; i < NoiseMixer::LAYERS; i++) player.setLayer(i, savedSources[i], savedGains[i]);
+        noiseMixer.update();
+
+        // the whole render path the producer task runs, the default algorithm at a fine volume step
+        player.setFineVolume(50 * VOLUME_FINE_STEPS - 1);
+        bench("render_frames", "mono", block, [&](int32_t n) { AudioPlayer::renderFrames(frames, n); });
+
+#if NOISE_LOOP
+        // the same path playing the flash loop and synthesizing the pink filter it is made from by default,
+        // the callback time the loop saves
+        const int savedAlgorithm = player.getCurrentAlgorithm();
+        const char* loopCases[][2] = {{"render_frames_flash_loop", "Flash loop"}, {"render_frames_synthesis", "Pink filter v2"}};
+        for (const auto& loopCase : loopCases) {
+            player.setAlgorithm(find_noise_algorithm(loopCase[1]));
+            for (int32_t f = 0; f < AUDIO_SAMPLE_RATE; f += 512) AudioPlayer::renderFrames(frames, 512); // past the crossfade
+            bench(loopCase[0], "mono", block, [&](int32_t n) { AudioPlayer::renderFrames(frames, n); });
+        }
+        player.setAlgorithm(savedAlgorithm);
+        for (int32_t f = 0; f < AUDIO_SAMPLE_RATE; f += 512) AudioPlayer::renderFrames(frames, 512);
+#endif
+    }
+
+    // ADPCM decoding of the uploaded loop, one 256-byte block per call: ns per block is ns_per_sample * block
+    const int blockAlign = 256;
+    const int perBlock = adpcm_samples_per_block(blockAlign);
+    std::vector<int16_t> pcm(static_cast<size_t>(perBlock) * 64);
+    for (int16_t& sample : pcm) sample = static_cast<int16_t>(pinkNoiseFilterV2Right.random().nextFloat() * 16000.0f);
+    std::vector<uint8_t> adpcm(static_cast<size_t>(blockAlign) * 64);
+    AdpcmState state;
+    for (int b = 0; b < 64; b++) adpcm_encode_block(&pcm[b * perBlock], blockAlign, state, &adpcm[b * blockAlign]);
+    static int16_t decoded[ADPCM_MAX_BLOCK_ALIGN * 2];
+    int adpcmBlock = 0;
+    bench("adpcm_decode_block", "mono", perBlock, [&](int32_t) {
+        adpcm_decode_block(&adpcm[adpcmBlock * blockAlign], blockAlign, decoded);
+        adpcmBlock = (adpcmBlock + 1) & 63;
+    });
+
+    printf("\n  ]\n}\n");
+    return 0;
+}
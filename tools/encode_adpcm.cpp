@@ -0,0 +1,147 @@
+// Encodes a 16-bit PCM WAV recording into a seamless IMA-ADPCM loop for the
+// "Uploaded loop" algorithm, upload the result in the web interface.
+//
+//   encode_adpcm <input.wav> [seconds] [fade ms] [block bytes] > loop.wav
+//
+// The input must be 44.1 kHz, channels are mixed to mono. The loop is cut to
+// whole ADPCM blocks; the audio after the cut is crossfaded with equal power
+// into the start, so the loop runs on from its end into its start seamlessly.
+// The SPIFFS partition of the "Minimal SPIFFS" scheme holds about 8 s.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <Arduino.h>
+#include "config.h"
+#include "adpcm.h"
+
+static const size_t SPIFFS_BUDGET = 180000; // bytes, leaves room for the file system itself
+
+static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+static uint16_t le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+static void put32(uint32_t v) {
+    for (int k = 0; k < 4; k++) putchar((v >> (8 * k)) & 0xFF);
+}
+
+static void put16(uint16_t v) {
+    putchar(v & 0xFF);
+    putchar(v >> 8);
+}
+
+// mono samples of a 16-bit PCM WAV, empty on error
+static std::vector<int16_t> readWav(const char* path) {
+    std::vector<int16_t> samples;
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return samples;
+    }
+    uint8_t header[12], chunk[8], fmt[16];
+    int channels = 0;
+    bool pcm = false;
+    if (fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        fclose(f);
+        return samples;
+    }
+    while (fread(chunk, 1, 8, f) == 8) {
+        uint32_t size = le32(chunk + 4);
+        if (!memcmp(chunk, "fmt ", 4) && size >= 16 && fread(fmt, 1, 16, f) == 16) {
+            channels = le16(fmt + 2);
+            pcm = le16(fmt) == 1 && le16(fmt + 14) == 16 && le32(fmt + 4) == AUDIO_SAMPLE_RATE && channels > 0;
+            fseek(f, size - 16 + (size & 1), SEEK_CUR);
+        } else if (!memcmp(chunk, "data", 4)) {
+            if (!pcm) break;
+            std::vector<int16_t> frame(channels);
+            while (fread(frame.data(), 2 * channels, 1, f) == 1) { // the WAV byte order is the host's on x86/ARM
+                int32_t sum = 0;
+                for (int c = 0; c < channels; c++) sum += frame[c];
+                samples.push_back(static_cast<int16_t>(sum / channels));
+            }
+            break;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    if (!pcm) fprintf(stderr, "%s: needs 16-bit PCM at %d Hz\n", path, AUDIO_SAMPLE_RATE);
+    return samples;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: encode_adpcm <input.wav> [seconds] [fade ms] [block bytes] > loop.wav\n");
+        return 1;
+    }
+    std::vector<int16_t> input = readWav(argv[1]);
+    double seconds = argc > 2 ? atof(argv[2]) : 0.0;
+    double fadeMs = argc > 3 ? atof(argv[3]) : 250.0;
+    int blockAlign = argc > 4 ? atoi(argv[4]) : 256;
+    if (blockAlign < 8 || blockAlign > ADPCM_MAX_BLOCK_ALIGN || blockAlign % 4) {
+        fprintf(stderr, "block bytes must be a multiple of 4 up to %d\n", ADPCM_MAX_BLOCK_ALIGN);
+        return 1;
+    }
+    const int perBlock = adpcm_samples_per_block(blockAlign);
+    const size_t fade = static_cast<size_t>(fadeMs * AUDIO_SAMPLE_RATE / 1000);
+
+    size_t total = input.size();
+    if (seconds > 0 && static_cast<size_t>(seconds * AUDIO_SAMPLE_RATE) + fade < total) total = static_cast<size_t>(seconds * AUDIO_SAMPLE_RATE) + fade;
+    if (total < fade + perBlock) {
+        fprintf(stderr, "input is too short for a loop with a %.0f ms crossfade\n", fadeMs);
+        return 1;
+    }
+    const size_t length = (total - fade) / perBlock * perBlock;
+    const size_t overhang = total - length; // at least fade, up to a block more
+
+    std::vector<int16_t> loop(input.begin(), input.begin() + length);
+    for (size_t i = 0; i < overhang && i < length; i++) {
+        double angle = 1.5707963 * (i + 0.5) / overhang;
+        double v = input[length + i] * cos(angle) + input[i] * sin(angle);
+        loop[i] = static_cast<int16_t>(lrint(v > 32767 ? 32767 : (v < -32768 ? -32768 : v)));
+    }
+
+    const uint32_t blocks = static_cast<uint32_t>(length / perBlock);
+    std::vector<uint8_t> data(static_cast<size_t>(blocks) * blockAlign);
+    AdpcmState state;
+    for (uint32_t b = 0; b < blocks; b++) adpcm_encode_block(&loop[b * perBlock], blockAlign, state, &data[b * blockAlign]);
+
+    // quality check: decode again and compare
+    std::vector<int16_t> decoded(perBlock);
+    double signal = 0.0, noise = 0.0;
+    for (uint32_t b = 0; b < blocks; b++) {
+        adpcm_decode_block(&data[b * blockAlign], blockAlign, decoded.data());
+        for (int i = 0; i < perBlock; i++) {
+            double s = loop[b * perBlock + i], e = decoded[i] - s;
+            signal += s * s;
+            noise += e * e;
+        }
+    }
+
+    const uint32_t dataBytes = static_cast<uint32_t>(data.size());
+    fwrite("RIFF", 1, 4, stdout);
+    put32(4 + 28 + 12 + 8 + dataBytes);
+    fwrite("WAVEfmt ", 1, 8, stdout);
+    put32(20);
+    put16(0x11); // IMA ADPCM
+    put16(1);
+    put32(AUDIO_SAMPLE_RATE);
+    put32(static_cast<uint32_t>(static_cast<uint64_t>(AUDIO_SAMPLE_RATE) * blockAlign / perBlock));
+    put16(blockAlign);
+    put16(4);
+    put16(2);
+    put16(perBlock);
+    fwrite("fact", 1, 4, stdout);
+    put32(4);
+    put32(static_cast<uint32_t>(length));
+    fwrite("data", 1, 4, stdout);
+    put32(dataBytes);
+    fwrite(data.data(), 1, dataBytes, stdout);
+
+    const size_t fileBytes = 60 + dataBytes;
+    fprintf(stderr, "%.2f s loop, %u blocks of %d bytes, %zu bytes, SNR %.1f dB\n", static_cast<double>(length) / AUDIO_SAMPLE_RATE,
+            blocks, blockAlign, fileBytes, noise > 0 ? 10.0 * log10(signal / noise) : 99.0);
+    if (fileBytes > SPIFFS_BUDGET) fprintf(stderr, "warning: larger than the %zu bytes the SPIFFS partition can hold, shorten it\n", SPIFFS_BUDGET);
+    return 0;
+}
@@ -0,0 +1,38 @@
+// minimal Arduino/FreeRTOS stand-ins so the sketch headers compile on a host machine for the tools
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <algorithm>
+
+#define PROGMEM
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+
+struct HostSerial {
+    template <typename T> void print(T) {}
+    template <typename T> void println(T) {}
+    void println() {}
+    template <typename... T> void printf(const char*, T...) {}
+};
+inline HostSerial Serial;
+
+// the host clock only moves when a test sets it, or by a blocking delay()
+inline unsigned long hostMillis = 0;
+inline void delay(unsigned long ms) { hostMillis += ms; }
+inline unsigned long millis() { return hostMillis; }
+inline void digitalWrite(int, int) {}
+
+typedef void* TaskHandle_t;
+#define pdTRUE 1
+#define pdMS_TO_TICKS(ms) (ms)
+inline uint32_t ulTaskNotifyTake(int, int) { return 0; }
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline int xTaskCreatePinnedToCore(void (*)(void*), const char*, int, void*, int, TaskHandle_t*, int) { return 1; }
+
+#endif
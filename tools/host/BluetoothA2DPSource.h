@@ -0,0 +1,40 @@
+// host stand-in for the ESP32-A2DP source: the Frame type and a no-op BluetoothA2DPSource,
+// advertise() plays a device found by the inquiry
+#ifndef HOST_BLUETOOTH_A2DP_SOURCE_H
+#define HOST_BLUETOOTH_A2DP_SOURCE_H
+
+#include "Arduino.h"
+
+struct __attribute__((packed)) Frame {
+    int16_t channel1;
+    int16_t channel2;
+
+    Frame(int v = 0) { channel1 = channel2 = v; }
+    Frame(int ch1, int ch2) { channel1 = ch1; channel2 = ch2; }
+};
+
+typedef uint8_t esp_bd_addr_t[6];
+#define ESP_BT_COD_SRVC_AUDIO 0
+
+class BluetoothA2DPSource {
+public:
+    BluetoothA2DPSource() { ssidCallback = nullptr; }
+    ~BluetoothA2DPSource() { ssidCallback = nullptr; }
+    void set_volume(int) {}
+    void start(const char*, int32_t (*)(Frame*, int32_t)) {}
+    void start() {}
+    void set_connected(bool) {}
+    void set_auto_reconnect(bool) {}
+    void end(bool) {}
+    void set_ssid_callback(bool (*callback)(const char*, esp_bd_addr_t, int)) { ssidCallback = callback; }
+    void set_data_callback_in_frames(int32_t (*)(Frame*, int32_t)) {}
+    void set_valid_cod_service(int) {}
+
+    static inline bool (*ssidCallback)(const char*, esp_bd_addr_t, int) = nullptr;
+    static void advertise(const char* name) {
+        esp_bd_addr_t address = {};
+        if (ssidCallback) ssidCallback(name, address, -60);
+    }
+};
+
+#endif
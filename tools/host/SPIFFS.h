@@ -0,0 +1,69 @@
+// SPIFFS stand-in for the tools: files live under $SPIFFS_ROOT, or the current directory
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace fs {
+
+class File {
+private:
+    FILE* file = nullptr;
+
+public:
+    File() {}
+    explicit File(FILE* f) : file(f) {}
+
+    explicit operator bool() const { return file != nullptr; }
+
+    size_t read(uint8_t* buffer, size_t size) { return file ? fread(buffer, 1, size, file) : 0; }
+
+    size_t write(const uint8_t* buffer, size_t size) { return file ? fwrite(buffer, 1, size, file) : 0; }
+
+    bool seek(uint32_t position) { return file && fseek(file, position, SEEK_SET) == 0; }
+
+    size_t size() {
+        if (!file) return 0;
+        long position = ftell(file);
+        fseek(file, 0, SEEK_END);
+        long end = ftell(file);
+        fseek(file, position, SEEK_SET);
+        return static_cast<size_t>(end);
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+};
+
+class SPIFFSFS {
+private:
+    static std::string hostPath(const char* path) {
+        const char* root = getenv("SPIFFS_ROOT");
+        return std::string(root ? root : ".") + path;
+    }
+
+public:
+    bool begin(bool formatOnFail = false) { return true; }
+
+    File open(const char* path, const char* mode = "r") {
+        return File(fopen(hostPath(path).c_str(), mode[0] == 'w' ? "wb" : "rb"));
+    }
+
+    bool exists(const char* path) {
+        FILE* f = fopen(hostPath(path).c_str(), "rb");
+        if (f) fclose(f);
+        return f != nullptr;
+    }
+
+    bool remove(const char* path) { return ::remove(hostPath(path).c_str()) == 0; }
+};
+
+} // namespace fs
+
+inline fs::SPIFFSFS SPIFFS;
+
+#endif
@@ -0,0 +1,71 @@
+// Generates noise_loop.cpp: a seamless mono noise loop stored as a PROGMEM array.
+// The generators are the sketch's own, compiled for the host.
+//
+//   make_noise_loop [algorithm] [seconds] [fade ms] > ../noise_loop.cpp
+//
+// algorithm: pink (default), brown, voss, blue, violet, grey
+//
+// The loop is rendered fade frames longer than needed; the overhang is
+// crossfaded with equal power into the start of the loop, so the last sample
+// runs on into the first exactly as the uninterrupted noise would.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "pink_noise.h"
+
+static void render(const char* algorithm, Frame* data, int32_t frameCount) {
+    if (!strcmp(algorithm, "brown")) brownNoiseGenerator.renderBlock(data, frameCount);
+    else if (!strcmp(algorithm, "voss")) vossPinkNoise.renderBlock(data, frameCount);
+    else if (!strcmp(algorithm, "blue")) blueNoise.renderBlock(data, frameCount);
+    else if (!strcmp(algorithm, "violet")) violetNoise.renderBlock(data, frameCount);
+    else if (!strcmp(algorithm, "grey")) greyNoise.renderBlock(data, frameCount);
+    else pinkNoiseFilterV2.renderBlock(data, frameCount);
+}
+
+int main(int argc, char** argv) {
+    const char* algorithm = argc > 1 ? argv[1] : "pink";
+    double seconds = argc > 2 ? atof(argv[2]) : 10.0;
+    double fadeMs = argc > 3 ? atof(argv[3]) : 250.0;
+
+    uint32_t length = static_cast<uint32_t>(seconds * AUDIO_SAMPLE_RATE);
+    uint32_t fade = static_cast<uint32_t>(fadeMs * AUDIO_SAMPLE_RATE / 1000);
+    if (length < 2 || fade > length) {
+        fprintf(stderr, "loop must be longer than its crossfade\n");
+        return 1;
+    }
+
+    pinkNoiseFilterV2.random().seed(0x5EED); // reproducible output
+    brownNoiseGenerator.random().seed(0x5EED);
+    vossPinkNoise.random().seed(0x5EED);
+    blueNoise.random().seed(0x5EED);
+    violetNoise.random().seed(0x5EED);
+    greyNoise.random().seed(0x5EED);
+    blueNoise.setProfile(NoiseProfile::slope(3.0f));
+    violetNoise.setProfile(NoiseProfile::slope(6.0f));
+    greyNoise.setProfile(NoiseProfile::grey());
+
+    std::vector<Frame> frames(length + fade);
+    for (uint32_t offset = 0; offset < frames.size(); offset += 1024) {
+        uint32_t count = std::min<uint32_t>(1024, frames.size() - offset);
+        render(algorithm, &frames[offset], count);
+    }
+
+    std::vector<int16_t> loop(length);
+    for (uint32_t i = 0; i < length; i++) loop[i] = frames[i].channel1;
+    for (uint32_t i = 0; i < fade; i++) {
+        double angle = 1.5707963267948966 * (i + 0.5) / fade;
+        double mixed = frames[i].channel1 * sin(angle) + frames[length + i].channel1 * cos(angle);
+        loop[i] = saturate_pcm(static_cast<int32_t>(lround(mixed)));
+    }
+
+    printf("// generated by tools/make_noise_loop %s %g %g\n", algorithm, seconds, fadeMs);
+    printf("#include <Arduino.h>\n\n");
+    printf("extern const uint32_t NOISE_LOOP_LENGTH = %u;\n\n", length);
+    printf("extern const int16_t NOISE_LOOP_SAMPLES[%u] PROGMEM = {\n", length);
+    for (uint32_t i = 0; i < length; i++) {
+        printf("%d%s", loop[i], i + 1 == length ? "\n" : (i % 20 == 19 ? ",\n" : ","));
+    }
+    printf("};\n");
+    return 0;
+}
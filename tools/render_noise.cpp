@@ -0,0 +1,61 @@
+// Renders a registered algorithm through the whole render pipeline (mixer,
+// crossfade, EQ, software gain and PCM conversion) into a file, faster than
+// realtime, and reports the throughput.
+//
+//   render_noise <algorithm name or index> [minutes] [file.wav | file.raw | -] [stereo]
+//
+// Writes a WAV to stdout without a file name or with "-"; a .raw name writes
+// headerless 16-bit stereo PCM. stereo is 0 (default) or 1. The synthesis
+// time per second of audio is the figure the firmware reports in its stats.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "audio_player.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: render_noise <algorithm> [minutes] [file.wav|file.raw|-] [stereo]\n");
+        for (int i = 0; i < NOISE_ALGORITHM_COUNT; i++) fprintf(stderr, "  %d. %s\n", i, noiseAlgorithms[i].name);
+        return 1;
+    }
+    int algorithm = find_noise_algorithm(argv[1]);
+    if (algorithm < 0 && argv[1][0] >= '0' && argv[1][0] <= '9') algorithm = atoi(argv[1]);
+    if (algorithm < 0 || algorithm >= NOISE_ALGORITHM_COUNT) {
+        fprintf(stderr, "unknown algorithm %s\n", argv[1]);
+        return 1;
+    }
+    double minutes = argc > 2 ? atof(argv[2]) : 1.0;
+    if (minutes <= 0) minutes = 1.0;
+    const char* path = argc > 3 ? argv[3] : "-";
+    const size_t length = strlen(path);
+    const bool raw = length > 4 && !strcmp(path + length - 4, ".raw");
+
+    seed_noise_generators();
+#if ADPCM_LOOP
+    adpcmLoop.open(); // loop.wav from $SPIFFS_ROOT, the uploaded loop is silent without it
+#endif
+    AudioPlayer player;
+    player.setStereo(argc > 4 && atoi(argv[4]));
+    player.setCrossfadeDuration(0); // start on the algorithm, not in a fade from the default
+    player.setAlgorithm(algorithm);
+
+    FileSink sink(path, !raw);
+    if (!sink.begin()) {
+        perror(path);
+        return 1;
+    }
+    const uint64_t frames = static_cast<uint64_t>(minutes * 60.0 * AUDIO_SAMPLE_RATE);
+    auto start = std::chrono::steady_clock::now();
+    AudioPlayer::renderTo(sink, frames);
+    sink.end();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(stderr, "%s: %.1f min rendered in %.2f s, %.0f frames/s, %.0fx realtime, %.1f ns/frame\n",
+            noiseAlgorithms[algorithm].name, minutes, elapsed, frames / elapsed, frames / elapsed / AUDIO_SAMPLE_RATE,
+            elapsed * 1e9 / frames);
+#if RENDER_STATS
+    fprintf(stderr, "synthesis: %u us per second of audio\n", player.getRenderStats().snapshot().synthesisUsPerSecond);
+#endif
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Spectral analysis shared by the host tools: radix-2 FFT, a Welch PSD with a
+// Hann window and 50% overlap, and a least-squares line through band levels.
+#ifndef TOOLS_SPECTRUM_H
+#define TOOLS_SPECTRUM_H
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+static void fft(std::vector<std::complex<double>>& a) {
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const double angle = -2.0 * M_PI / len;
+        const std::complex<double> step(cos(angle), sin(angle));
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0);
+            for (size_t j = 0; j < len / 2; j++) {
+                std::complex<double> u = a[i + j], v = a[i + j + len / 2] * w;
+                a[i + j] = u + v;
+                a[i + j + len / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+// Welch PSD, fed one sample at a time; size must be a power of two
+class WelchPsd {
+private:
+    int size;
+    int fill = 0;
+    std::vector<double> window, segment, psd;
+    std::vector<std::complex<double>> spectrum;
+
+public:
+    int64_t segments = 0;
+
+    explicit WelchPsd(int size) : size(size), window(size), segment(size, 0.0), psd(size / 2, 0.0), spectrum(size) {
+        for (int i = 0; i < size; i++) window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / size);
+    }
+
+    void add(double sample) {
+        segment[fill++] = sample;
+        if (fill < size) return;
+        for (int k = 0; k < size; k++) spectrum[k] = segment[k] * window[k];
+        fft(spectrum);
+        for (int k = 0; k < size / 2; k++) psd[k] += std::norm(spectrum[k]);
+        segments++;
+        const int hop = size / 2;
+        for (int k = 0; k < hop; k++) segment[k] = segment[k + hop];
+        fill = hop;
+    }
+
+    // mean density of the bins in [lowHz, highHz), in dB
+    double bandLevel(double lowHz, double highHz, double sampleRate) const {
+        double power = 0.0;
+        int bins = 0;
+        for (int k = 1; k < size / 2; k++) {
+            const double f = static_cast<double>(k) * sampleRate / size;
+            if (f >= lowHz && f < highHz) {
+                power += psd[k];
+                bins++;
+            }
+        }
+        return 10.0 * log10(power / bins / segments);
+    }
+};
+
+// least-squares line y = slope * x + offset and the largest distance of a point from it
+struct LineFit {
+    double slope = 0.0;
+    double deviation = 0.0;
+};
+
+static LineFit fitLine(const std::vector<double>& x, const std::vector<double>& y) {
+    const size_t n = x.size();
+    double meanX = 0.0, meanY = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        meanX += x[i];
+        meanY += y[i];
+    }
+    meanX /= n;
+    meanY /= n;
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sxy += (x[i] - meanX) * (y[i] - meanY);
+        sxx += (x[i] - meanX) * (x[i] - meanX);
+    }
+    LineFit fit;
+    fit.slope = sxy / sxx;
+    for (size_t i = 0; i < n; i++) {
+        fit.deviation = fmax(fit.deviation, fabs(y[i] - meanY - fit.slope * (x[i] - meanX)));
+    }
+    return fit;
+}
+
+#endif
@@ -0,0 +1,146 @@
+// Offline spectral check of the noise algorithms, usable as a pass/fail gate.
+// Renders through AudioPlayer::renderAlgorithm, so the PCM conversion and the
+// NOISE_FIXED_POINT / NOISE_RANDOM_ENGINE settings in config.h are covered.
+//
+//   spectrum_check [minutes per algorithm] [algorithm name or number]
+//
+// For every algorithm it reports a Welch PSD reduced to octave bands, the
+// least-squares slope over the fit range, the worst band deviation from that
+// line, crest factor, DC offset and clipping rate. The exit code is non-zero
+// when an algorithm with a target spectrum misses its tolerances or is silent.
+// Other silent algorithms, e.g. "Uploaded loop" without a file, are reported
+// as skipped; checking only such an algorithm fails.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "audio_player.h"
+#include "spectrum.h"
+
+static const int FFT_SIZE = 8192;    // 5.4 Hz resolution at 44.1 kHz
+static const double FIT_LOW = 62.5;  // fit range in Hz, octave bands start here
+static const double FIT_HIGH = 16000.0;
+
+struct Target {
+    const char* name;
+    bool gated;          // false: measured and reported only
+    double slope;        // dB/octave
+    double slopeTolerance;
+    double bandTolerance; // dB from the fitted line
+    double maxDc;         // mean of the whole render, fraction of full scale
+    double maxClipping;   // fraction of samples at full scale
+};
+
+// matched to the registry by name, algorithms without an entry are reported
+// only. The mean of 1/f noise wanders over a few minutes, so the DC limits are
+// loose and only catch real offsets.
+static const Target TARGETS[] = {
+    {"Pink filter v2", true, -3.0, 0.15, 0.5, 0.02, 1e-4},
+    {"Brown", true, -6.0, 0.3, 1.5, 0.1, 0.05},             // a random walk held at +/-1, it rests on the rails by design
+    {"Pink cursor", false, 0.0, 0.0, 0.0, 0.02, 1e-4},      // 16-tap moving average, a lowpass rather than pink
+    {"Pink Voss-McCartney", true, -3.0, 0.3, 1.5, 0.02, 1e-4}, // Voss-McCartney ripples around the line
+    {"Blue", true, 3.0, 0.3, 1.0, 0.02, 1e-4},
+    {"Violet", true, 6.0, 0.3, 1.5, 0.02, 1e-4},            // the top octave lifts near Nyquist
+    {"Grey", false, 0.0, 0.0, 0.0, 0.02, 1e-4},
+    {"Custom slope", true, -3.0, 0.3, 1.0, 0.02, 1e-4},
+    {"Soundscape", false, 0.0, 0.0, 0.0, 0.1, 1e-3},        // the default mix has a brown base layer
+};
+
+static Target targetFor(const char* name) {
+    for (const Target& target : TARGETS) {
+        if (!strcmp(target.name, name)) return target;
+    }
+    return {name, false, 0.0, 0.0, 0.0, 0.02, 1e-4};
+}
+
+enum Result { FAILED, PASSED, SKIPPED };
+
+// renders and analyses one algorithm
+static Result check(int algorithm, double minutes) {
+    const Target target = targetFor(noiseAlgorithms[algorithm].name);
+    const int64_t total = static_cast<int64_t>(minutes * 60.0 * AUDIO_SAMPLE_RATE);
+    WelchPsd psd(FFT_SIZE);
+
+    Frame frames[256];
+    double sum = 0.0, sumSquares = 0.0;
+    int peak = 0;
+    int64_t clipped = 0, rendered = 0;
+    AudioPlayer::renderAlgorithm(algorithm, frames, 256); // settle the filter states
+    while (rendered < total) {
+        AudioPlayer::renderAlgorithm(algorithm, frames, 256);
+        for (int i = 0; i < 256; i++) {
+            int v = frames[i].channel1;
+            sum += v;
+            sumSquares += static_cast<double>(v) * v;
+            if (abs(v) > peak) peak = abs(v);
+            if (v >= 32767 || v <= -32767) clipped++;
+            psd.add(v / 32768.0);
+        }
+        rendered += 256;
+    }
+
+    // octave band densities and a least-squares line through them
+    std::vector<double> octaves, levels;
+    for (double low = FIT_LOW; low * 2 <= FIT_HIGH && low * 2 <= 0.5 * AUDIO_SAMPLE_RATE; low *= 2) {
+        octaves.push_back(log2(low));
+        levels.push_back(psd.bandLevel(low, 2 * low, AUDIO_SAMPLE_RATE));
+    }
+    const LineFit fit = fitLine(octaves, levels);
+    const double slope = fit.slope;
+    const double deviation = fit.deviation;
+    const size_t n = octaves.size();
+
+    const double rms = sqrt(sumSquares / rendered);
+    if (rms == 0.0 || std::isnan(slope)) { // nothing to fit
+        printf("%-20s silent  %s\n", target.name, target.gated ? "FAIL" : "SKIPPED");
+        return target.gated ? FAILED : SKIPPED;
+    }
+    const double crest = rms > 0 ? 20.0 * log10(peak / rms) : 0.0;
+    const double dc = sum / rendered / 32768.0;
+    const double clipping = static_cast<double>(clipped) / rendered;
+
+    bool pass = clipping <= target.maxClipping && fabs(dc) <= target.maxDc;
+    if (target.gated) {
+        pass = pass && fabs(slope - target.slope) <= target.slopeTolerance && deviation <= target.bandTolerance;
+    }
+
+    printf("%-20s slope %+6.2f dB/oct (target %s%+.1f)  band dev %4.2f dB  rms %5.1f dBFS  crest %4.1f dB  dc %+.5f  clip %.2e  %s\n",
+           target.name, slope, target.gated ? "" : "~", target.slope, deviation, 20.0 * log10(rms / 32768.0), crest, dc, clipping,
+           pass ? (target.gated ? "PASS" : "ok") : "FAIL");
+    printf("                     octaves:");
+    for (size_t i = 1; i < n; i++) printf(" %+5.1f", levels[i] - levels[i - 1]);
+    printf("\n");
+    return pass ? PASSED : FAILED;
+}
+
+int main(int argc, char** argv) {
+    double minutes = argc > 1 ? atof(argv[1]) : 1.0;
+    if (minutes <= 0) minutes = 1.0;
+    int only = -1;
+    if (argc > 2) {
+        only = find_noise_algorithm(argv[2]);
+        if (only < 0 && argv[2][0] >= '0' && argv[2][0] <= '9') only = atoi(argv[2]);
+        if (only < 0 || only >= NOISE_ALGORITHM_COUNT) {
+            fprintf(stderr, "unknown algorithm %s\n", argv[2]);
+            for (int i = 0; i < NOISE_ALGORITHM_COUNT; i++) fprintf(stderr, "  %d. %s\n", i, noiseAlgorithms[i].name);
+            return 1;
+        }
+    }
+
+    seed_noise_generators();
+    AudioPlayer player; // designs the colored noise profiles
+    noiseMixer.update(); // and sets the default soundscape layers
+    player.setStereo(false);
+
+    bool pass = true;
+    int checked = 0;
+    for (int alg = 0; alg < NOISE_ALGORITHM_COUNT; alg++) {
+        if (only >= 0 && alg != only) continue;
+        const Result result = check(alg, minutes);
+        if (result == FAILED) pass = false;
+        if (result != SKIPPED) checked++;
+    }
+    pass = pass && checked > 0;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
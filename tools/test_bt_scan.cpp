@@ -0,0 +1,68 @@
+// Simulation of the Bluetooth scan in handleDeviceState on a fake clock: the
+// loop is stepped every 100 ms like loop() does, devices advertise at set
+// times through the host A2DP stand-in, and the scan has to end at the right
+// time with the right device list. A blocking delay() advances the clock too,
+// so a stalled loop shows up as a late step.
+
+#include <cstdio>
+#include <vector>
+#include "bt_scan.h"
+
+static AudioPlayer player;
+static bool pass = true;
+
+struct Advert {
+    unsigned long atMs; // after the scan was started
+    const char* name;
+};
+
+// runs one scan like the sketch, returns when it ended (ms after the start)
+static unsigned long simulate(const char* storedSpeaker, const std::vector<Advert>& adverts, unsigned long& worstStepMs) {
+    const unsigned long startMs = hostMillis = 100000;
+    BtScan scan(player);
+    scan.start(hostMillis, storedSpeaker);
+    size_t next = 0;
+    worstStepMs = 0;
+    while (hostMillis - startMs < 60000) {
+        hostMillis += 100; // delay(100) at the end of loop()
+        while (next < adverts.size() && adverts[next].atMs <= hostMillis - startMs) BluetoothA2DPSource::advertise(adverts[next++].name);
+        const unsigned long before = hostMillis;
+        const bool done = scan.update(hostMillis);
+        if (!done && hostMillis - before > worstStepMs) worstStepMs = hostMillis - before;
+        if (done) return before - startMs;
+    }
+    return 0;
+}
+
+static void expect(const char* what, unsigned long value, unsigned long low, unsigned long high) {
+    const bool ok = value >= low && value <= high;
+    printf("%-40s %6lu  (%lu..%lu)  %s\n", what, value, low, high, ok ? "PASS" : "FAIL");
+    pass = pass && ok;
+}
+
+int main() {
+    const unsigned long inquiryMs = BtScan::SETTLE_TIME;
+    unsigned long worstStepMs = 0;
+
+    // the stored speaker is seen 4 s into the inquiry, the scan lingers 3 s more
+    unsigned long endMs = simulate("Speaker", {{inquiryMs + 2000, "Phone"}, {inquiryMs + 4000, "Speaker"}, {inquiryMs + 6000, "Speaker"}, {inquiryMs + 6500, "TV"}}, worstStepMs);
+    expect("stored speaker found, end ms", endMs, inquiryMs + 4000 + BtScan::LINGER_TIME, inquiryMs + 4100 + BtScan::LINGER_TIME);
+    expect("devices found", player.getDevices()->size(), 3, 3);
+    expect("longest step while scanning ms", worstStepMs, 0, 0);
+
+    // an advertisement before the inquiry is not part of it
+    endMs = simulate("Speaker", {{500, "Speaker"}}, worstStepMs);
+    expect("seen before the inquiry, end ms", endMs, inquiryMs + BtScan::TIMEOUT, inquiryMs + BtScan::TIMEOUT + 100);
+
+    // the stored speaker is not around: the full inquiry
+    endMs = simulate("Speaker", {{inquiryMs + 1000, "Phone"}}, worstStepMs);
+    expect("stored speaker missing, end ms", endMs, inquiryMs + BtScan::TIMEOUT, inquiryMs + BtScan::TIMEOUT + 100);
+    expect("devices found", player.getDevices()->size(), 1, 1);
+
+    // no stored speaker: a device without a name must not end the scan early
+    endMs = simulate("", {{inquiryMs + 1000, ""}, {inquiryMs + 2000, "Phone"}}, worstStepMs);
+    expect("nothing stored, nameless device, end ms", endMs, inquiryMs + BtScan::TIMEOUT, inquiryMs + BtScan::TIMEOUT + 100);
+
+    printf("bt scan: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+// Test of the integer (NOISE_FIXED_POINT) generators against the float ones:
+// both are fed the same random stream and every output sample is compared in
+// 16-bit LSBs after both are saturated to int16 like the PCM output, at 44.1
+// and 48 kHz. Every generator has to stay within 2 LSB (the integer cursor
+// truncates its white input and its average, 1 LSB each) and below 1.5 LSB
+// RMS error.
+//
+//   test_fixed_point [samples]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "pink_noise.h"
+
+static bool pass = true;
+
+struct ErrorStats {
+    int32_t worst = 0;
+    double squares = 0;
+    int32_t count = 0;
+
+    void add(float reference, int32_t fixed) {
+        const int32_t error = abs(saturate_pcm(static_cast<int32_t>(lrintf(reference * 32768.0f))) - saturate_pcm(fixed));
+        if (error > worst) worst = error;
+        squares += static_cast<double>(error) * error;
+        count++;
+    }
+
+    void report(const char* name, uint32_t sampleRate, int32_t bound) {
+        const double rms = sqrt(squares / count);
+        const bool ok = worst <= bound && rms < 1.5;
+        printf("%-8s %5u Hz  worst %2d LSB (max %d)  rms %.2f LSB  %s\n", name, sampleRate, worst, bound, rms, ok ? "PASS" : "FAIL");
+        pass = pass && ok;
+    }
+};
+
+template <uint32_t SampleRate>
+static void compare(int32_t samples) {
+    PinkNoiseFilterV2<SampleRate> pink;
+    PinkNoiseFilterFixed<SampleRate> pinkFixed;
+    BrownNoiseGenerator<SampleRate> brown;
+    BrownNoiseGeneratorFixed<SampleRate> brownFixed;
+    PinkNoiseCursor cursor, cursorFixed;
+    pink.random().seed(1);
+    pinkFixed.random().seed(1);
+    brown.random().seed(2);
+    brownFixed.random().seed(2);
+    cursor.random().seed(3);
+    cursorFixed.random().seed(3);
+
+    ErrorStats pinkError, brownError, cursorError;
+    for (int32_t i = 0; i < samples; i++) {
+        pinkError.add(pink.generateSample(), pinkFixed.generateSample());
+        brownError.add(brown.generateSample(), brownFixed.generateSample());
+        cursorError.add(cursor.generateSample(), cursorFixed.generateSampleQ15());
+    }
+    pinkError.report("pink", SampleRate, 2);
+    brownError.report("brown", SampleRate, 2);
+    cursorError.report("cursor", SampleRate, 2);
+}
+
+int main(int argc, char** argv) {
+    const int32_t samples = argc > 1 ? atoi(argv[1]) : 4000000;
+    compare<44100>(samples);
+    compare<48000>(samples);
+    printf("fixed point: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
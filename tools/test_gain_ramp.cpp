@@ -0,0 +1,79 @@
+// Test of the software gain stage: constant full-scale frames are run through
+// GainStage while the target changes at random, also in the middle of a ramp
+// and in random block sizes. Between two changes the level has to move toward
+// the target only, by at most one ramp step per frame, and settle on it in the
+// ramp time; the attenuation table has to fall with every step. Every volume
+// step, fine or a button press, has to change the software gain.
+//
+//   test_gain_ramp
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "gain_stage.h"
+
+static const int16_t LEVEL = 32767;
+static const uint32_t RAMP_MS = 20;
+
+int main() {
+    bool pass = true;
+
+    int tableRises = 0;
+    for (int i = 1; i < GainTable::SIZE; i++) {
+        if (gainTable.q15[i] > gainTable.q15[i - 1]) tableRises++;
+    }
+    printf("gain table: %d entries, %d rises, unity %d, last %d  %s\n", GainTable::SIZE, tableRises, gainTable.q15[0],
+           gainTable.q15[GainTable::SIZE - 1], tableRises == 0 && gainTable.q15[0] == 32768 ? "PASS" : "FAIL");
+    pass = pass && tableRises == 0 && gainTable.q15[0] == 32768;
+
+    // the volume curve: each fine step attenuates more than the one above it, full volume is unity, 0 mutes
+    int flatSteps = 0;
+    for (int volume = 1; volume <= 100 * VOLUME_FINE_STEPS; volume++) {
+        if (volume_attenuation(volume) >= volume_attenuation(volume - 1)) flatSteps++;
+    }
+    const bool curveOk = flatSteps == 0 && volume_attenuation(100 * VOLUME_FINE_STEPS) == 0 && volume_attenuation(0) >= GainTable::SIZE;
+    printf("volume curve: %d fine steps, %d without a gain change, lowest step %.1f dB  %s\n", 100 * VOLUME_FINE_STEPS, flatSteps,
+           -GAIN_TABLE_STEP_DB * volume_attenuation(1), curveOk ? "PASS" : "FAIL");
+    pass = pass && curveOk;
+
+    GainStage gain;
+    gain.setRampTime(RAMP_MS, AUDIO_SAMPLE_RATE);
+    const int32_t rampFrames = AUDIO_SAMPLE_RATE * RAMP_MS / 1000;
+    const int32_t maxStep = (LEVEL + rampFrames - 1) / rampFrames + 1; // one ramp step of the level, plus rounding
+    std::mt19937 random(1);
+    static Frame block[512];
+    int previous = LEVEL; // the stage starts at unity
+    int reversals = 0, bigSteps = 0, overshoots = 0, unsettled = 0, unbalanced = 0, changes = 0;
+
+    for (int change = 0; change < 2000; change++) {
+        const int steps = random() % 3 == 0 ? GainTable::SIZE : static_cast<int>(random() % GainTable::SIZE);
+        gain.setAttenuation(steps);
+        const int goal = steps >= GainTable::SIZE ? 0 : (LEVEL * gainTable.q15[steps]) >> 15;
+        const int direction = goal > previous ? 1 : (goal < previous ? -1 : 0);
+        // half of the changes come before the last ramp has settled
+        const int32_t frames = random() % 2 ? rampFrames + 64 : static_cast<int32_t>(random() % rampFrames);
+        for (int32_t done = 0; done < frames;) {
+            const int32_t count = std::min<int32_t>(1 + random() % 512, frames - done);
+            for (int32_t i = 0; i < count; i++) block[i] = Frame(LEVEL, -LEVEL);
+            gain.process(block, count);
+            for (int32_t i = 0; i < count; i++) {
+                const int level = block[i].channel1;
+                if (block[i].channel2 != -level && block[i].channel2 != -level - 1) unbalanced++; // both channels get the same gain
+                if ((level - previous) * direction < 0) reversals++;
+                if (abs(level - previous) > maxStep) bigSteps++;
+                if ((direction > 0 && level > goal) || (direction < 0 && level < goal)) overshoots++;
+                previous = level;
+            }
+            done += count;
+        }
+        if (frames > rampFrames && previous != goal) unsettled++;
+        changes++;
+    }
+
+    const bool ok = reversals == 0 && bigSteps == 0 && overshoots == 0 && unsettled == 0 && unbalanced == 0;
+    printf("gain ramp: %d target changes, %d reversals, %d steps above %d, %d overshoots, %d not settled in %u ms, %d unbalanced  %s\n",
+           changes, reversals, bigSteps, maxStep, overshoots, unsettled, RAMP_MS, unbalanced, ok ? "PASS" : "FAIL");
+    pass = pass && ok;
+    printf("gain stage: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Statistical test of the white noise engines and of how the generators are
+// seeded: mean, variance, bit balance and autocorrelation of each engine, and
+// that the left and right channel of every stereo algorithm are independent
+// after seed_noise_generators(), which on the host has no hardware RNG.
+//
+// The bounds are 5 standard errors of the estimate, so a good engine fails
+// about once in a million runs; the seeds are fixed, so in practice never.
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "audio_player.h"
+
+static const int N = 1 << 20;
+static const int MAX_LAG = 32;
+static bool pass = true;
+
+static void expect(const char* engine, const char* what, double value, double low, double high) {
+    const bool ok = value >= low && value <= high;
+    printf("%-12s %-26s %10.6f  (%.6f..%.6f)  %s\n", engine, what, value, low, high, ok ? "PASS" : "FAIL");
+    pass = pass && ok;
+}
+
+// correlation coefficient of two sequences
+static double correlation(const float* a, const float* b, int count) {
+    double ab = 0, aa = 0, bb = 0;
+    for (int i = 0; i < count; i++) {
+        ab += static_cast<double>(a[i]) * b[i];
+        aa += static_cast<double>(a[i]) * a[i];
+        bb += static_cast<double>(b[i]) * b[i];
+    }
+    return aa > 0 && bb > 0 ? ab / sqrt(aa * bb) : NAN;
+}
+
+template <typename Engine>
+static void testEngine(const char* name) {
+    BasicNoiseRandom<Engine> random;
+    random.seed(12345);
+    std::vector<float> x(N);
+    std::vector<int> bits(32);
+    for (int i = 0; i < N; i++) {
+        const int32_t v = random.nextInt();
+        for (int b = 0; b < 32; b++) bits[b] += (v >> b) & 1;
+        x[i] = v * (1.0f / 2147483648.0f);
+    }
+
+    double mean = 0, power = 0;
+    for (float v : x) {
+        mean += v;
+        power += static_cast<double>(v) * v;
+    }
+    mean /= N;
+    const double variance = power / N - mean * mean;
+    const double meanError = 5 * sqrt(1.0 / 3 / N);
+    expect(name, "mean", mean, -meanError, meanError);
+    expect(name, "variance", variance, 1.0 / 3 - 5 * sqrt(4.0 / 45 / N), 1.0 / 3 + 5 * sqrt(4.0 / 45 / N));
+
+    int worstBit = 0;
+    for (int b = 1; b < 32; b++) {
+        if (fabs(bits[b] - N / 2.0) > fabs(bits[worstBit] - N / 2.0)) worstBit = b;
+    }
+    const double bitError = 5 * 0.5 / sqrt(N);
+    expect(name, "worst bit share of ones", static_cast<double>(bits[worstBit]) / N, 0.5 - bitError, 0.5 + bitError);
+
+    // white: no correlation with itself at any lag, a filter or a short cycle would show here
+    double worstLag = 0;
+    for (int lag = 1; lag <= MAX_LAG; lag++) {
+        const double r = correlation(x.data(), x.data() + lag, N - lag);
+        if (fabs(r) > fabs(worstLag)) worstLag = r;
+    }
+    expect(name, "worst autocorrelation", worstLag, -5 / sqrt(N), 5 / sqrt(N));
+}
+
+int main() {
+    testEngine<XorShift32>("XorShift32");
+    testEngine<Pcg32>("Pcg32");
+
+    // left and right of every stereo algorithm must not be the same sequence;
+    // filtered noise has fewer independent samples, so the bound is loose
+    seed_noise_generators();
+    AudioPlayer player;
+    player.setStereo(true);
+    static Frame block[512];
+    std::vector<float> left(N), right(N);
+    for (int alg = 0; alg < NOISE_ALGORITHM_COUNT; alg++) {
+        if (noiseAlgorithms[alg].alwaysStereo) continue; // tones are stereo by design
+        for (int i = 0; i < N; i += 512) {
+            AudioPlayer::renderAlgorithm(alg, block, 512);
+            for (int k = 0; k < 512; k++) {
+                left[i + k] = block[k].channel1;
+                right[i + k] = block[k].channel2;
+            }
+        }
+        const double r = correlation(left.data(), right.data(), N);
+        if (std::isnan(r)) {
+            printf("%-12s %-26s %10s  skipped, silent\n", "stereo", noiseAlgorithms[alg].name, "-");
+            continue;
+        }
+        expect("stereo", noiseAlgorithms[alg].name, r, -0.2, 0.2);
+    }
+
+    printf("noise random: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
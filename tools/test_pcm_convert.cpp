@@ -0,0 +1,91 @@
+// Test of the float to PCM conversion at the edges: +/-1.0, values far out of
+// range, infinities, NaN (full scale of its sign, as documented), zero and
+// denormals, and a round trip of every 16-bit level. Each value is placed at
+// every position of a block so the vectorized loop and its scalar tail both
+// see it, through the mono and the stereo kernel, with and without dither.
+//
+//   test_pcm_convert
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include "pcm_convert.h"
+
+static bool pass = true;
+
+struct Case {
+    const char* name;
+    float value;
+    int expected; // without dither
+};
+
+// converts value at every position of a block of zeros, returns the worst distance from expected
+static int worstError(PcmConverter& converter, float value, int expected, bool stereo) {
+    static const int32_t BLOCK = 37; // a vector loop and a tail
+    float left[BLOCK], right[BLOCK];
+    Frame out[BLOCK];
+    int worst = 0;
+    for (int32_t position = 0; position < BLOCK; position++) {
+        for (int32_t i = 0; i < BLOCK; i++) left[i] = right[i] = 0.0f;
+        left[position] = value;
+        right[BLOCK - 1 - position] = value;
+        if (stereo) converter.convert(left, right, out, BLOCK);
+        else converter.convert(left, out, BLOCK);
+        worst = std::max(worst, abs(out[position].channel1 - expected));
+        if (stereo) worst = std::max(worst, abs(out[BLOCK - 1 - position].channel2 - expected));
+        else worst = std::max(worst, abs(out[position].channel2 - expected));
+    }
+    return worst;
+}
+
+int main() {
+    const Case cases[] = {
+        {"+1.0", 1.0f, 32767},
+        {"-1.0", -1.0f, -32767},
+        {"just above +1.0", nextafterf(1.0f, 2.0f), 32767},
+        {"just below -1.0", nextafterf(-1.0f, -2.0f), -32767},
+        {"+1.5", 1.5f, 32767},
+        {"-1.5", -1.5f, -32767},
+        {"+1e30", 1e30f, 32767},
+        {"-1e30", -1e30f, -32767},
+        {"+FLT_MAX", FLT_MAX, 32767},
+        {"-FLT_MAX", -FLT_MAX, -32767},
+        {"+inf", INFINITY, 32767},
+        {"-inf", -INFINITY, -32767},
+        {"+NaN", NAN, 32767},
+        {"-NaN", -NAN, -32767},
+        {"+0", 0.0f, 0},
+        {"-0", -0.0f, 0},
+        {"+denormal", FLT_MIN / 4, 0},
+        {"-denormal", -FLT_MIN / 4, 0},
+        {"+0.5", 0.5f, 16384},
+        {"-0.5", -0.5f, -16383},
+    };
+
+    PcmConverter converter;
+    for (const Case& c : cases) {
+        converter.setDither(false);
+        const int mono = worstError(converter, c.value, c.expected, false);
+        const int stereo = worstError(converter, c.value, c.expected, true);
+        // dither moves a sample by at most 1 LSB, never past full scale
+        converter.setDither(true);
+        const int ditherMono = worstError(converter, c.value, c.expected, false);
+        const int ditherStereo = worstError(converter, c.value, c.expected, true);
+        const bool ok = mono == 0 && stereo == 0 && ditherMono <= 1 && ditherStereo <= 1;
+        printf("%-18s -> %6d  error %d/%d, dithered %d/%d LSB  %s\n", c.name, c.expected, mono, stereo, ditherMono, ditherStereo,
+               ok ? "PASS" : "FAIL");
+        pass = pass && ok;
+    }
+
+    // every level survives the trip through float
+    converter.setDither(false);
+    int roundTrip = 0;
+    for (int level = -32767; level <= 32767; level++) {
+        roundTrip = std::max(roundTrip, worstError(converter, level / 32767.0f, level, true));
+    }
+    printf("round trip of -32767..32767, worst error %d LSB  %s\n", roundTrip, roundTrip == 0 ? "PASS" : "FAIL");
+    pass = pass && roundTrip == 0;
+
+    printf("pcm convert: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
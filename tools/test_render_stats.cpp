@@ -0,0 +1,92 @@
+// Test of the render statistics on the host backend with a fake clock: the
+// test sets the tick count before every begin/end, so callbacks of known
+// length at known intervals are simulated exactly, and the counters,
+// histogram, budget share, jitter and synthesis time must equal what was
+// simulated. The steady clock behind the real ticks is checked on its own.
+
+#include <chrono>
+#include <cstdio>
+#include "render_stats.h"
+
+static const uint32_t TICKS_PER_US = 1000; // host ticks are nanoseconds
+static uint32_t nowTicks = 0;
+static bool pass = true;
+
+static uint32_t fakeClock() { return nowTicks; }
+
+static void expect(const char* what, uint32_t value, uint32_t low, uint32_t high) {
+    const bool ok = value >= low && value <= high;
+    printf("%-28s %8u  (%u..%u)  %s\n", what, value, low, high, ok ? "PASS" : "FAIL");
+    pass = pass && ok;
+}
+
+// one callback of frameCount frames that renders for renderUs, started at startUs
+static void callback(RenderStats& stats, uint32_t startUs, int32_t frameCount, uint32_t renderUs) {
+    nowTicks = startUs * TICKS_PER_US;
+    uint32_t ticks = stats.begin();
+    nowTicks += renderUs * TICKS_PER_US;
+    stats.end(ticks, frameCount);
+}
+
+int main() {
+    // the real clock: a 1 ms wait is at least 1 ms of ticks, a preemption only adds
+    const uint32_t realStart = stats_ticks();
+    const auto waitEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+    while (std::chrono::steady_clock::now() < waitEnd) {}
+    expect("steady clock us in 1 ms", (stats_ticks() - realStart) / stats_ticks_per_us(), 1000, UINT32_MAX);
+
+    hostStatsClock = fakeClock;
+    RenderStats stats;
+    const int32_t frames = 441; // 10 ms of audio
+    const uint32_t intervalUs = 10000;
+
+    // 20 callbacks of 300 us every 10 ms, the 21st starts 5 ms late. The
+    // ticks wrap around during the run, which must not show anywhere.
+    const uint32_t startUs = (UINT32_MAX - 50000 * TICKS_PER_US) / TICKS_PER_US;
+    for (uint32_t i = 0; i < 20; i++) callback(stats, startUs + i * intervalUs, frames, 300);
+    callback(stats, startUs + 20 * intervalUs + 5000, frames, 300);
+
+    RenderStatsSnapshot s = stats.snapshot();
+    expect("calls", s.calls, 21, 21);
+    expect("frames", s.frames, 21 * frames, 21 * frames);
+    expect("min frames", s.minFrames, frames, frames);
+    expect("max frames", s.maxFrames, frames, frames);
+    expect("worst render us", s.worstRenderUs, 300, 300);
+    expect("worst load permille", s.worstLoadPermille, 30, 30);
+    expect("max jitter us", s.maxJitterUs, 5000, 5000);
+    expect("mean jitter us", s.meanJitterUs, 5000 / 20, 5000 / 20);
+    uint32_t histogramCalls = 0;
+    for (int k = 0; k < RenderStatsSnapshot::BUCKETS; k++) histogramCalls += s.histogram[k];
+    expect("histogram calls", histogramCalls, 21, 21);
+    expect("histogram 256..512 us", s.histogram[9], 21, 21);
+
+    // synthesis: 200 us per 441 frames is 20000 us per second of audio, in
+    // blocks shorter than a microsecond tick too, which must add up
+    for (int i = 0; i < 50; i++) {
+        uint32_t ticks = stats_ticks();
+        nowTicks += 200 * TICKS_PER_US;
+        stats.addSynthesis(ticks, frames);
+    }
+    expect("synthesis us per second", stats.snapshot().synthesisUsPerSecond, 20000, 20000);
+    RenderStats shortBlocks;
+    for (int i = 0; i < 2000; i++) {
+        uint32_t ticks = stats_ticks();
+        nowTicks += 700; // 0.7 us
+        shortBlocks.addSynthesis(ticks, 1);
+    }
+    expect("synthesis of sub-us blocks", shortBlocks.snapshot().synthesisUsPerSecond, 700 * 441 / 10, 700 * 441 / 10); // 0 without the carried remainder
+
+    // a reset clears everything with the next callback, including the jitter reference
+    stats.reset();
+    callback(stats, nowTicks / TICKS_PER_US + 50000, frames, 100);
+    s = stats.snapshot();
+    expect("calls after reset", s.calls, 1, 1);
+    expect("max jitter after reset", s.maxJitterUs, 0, 0);
+    expect("worst render after reset", s.worstRenderUs, 100, 100);
+    expect("histogram after reset", s.histogram[7], 1, 1); // 64..128 us
+    stats.addSynthesis(stats_ticks(), frames);
+    expect("synthesis after reset", stats.snapshot().synthesisUsPerSecond, 0, 0); // 20000 before
+
+    printf("render stats: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// Stress test of the SPSC PCM ring: a producer thread renders into writeRegion/
+// commit and a consumer thread reads like the A2DP callback, both with random
+// block sizes and random pauses. Every frame carries the low bits of its
+// sequence number, so a lost, repeated or torn frame shows up as a gap, and of
+// the consumer's read index when it was written: the frames queued ahead of
+// it, which is how long it waits in the ring.
+//
+//   test_ring_buffer [frames]
+//
+// Checks that the frames come out complete and in order, that short reads are
+// padded with silence and that each of them is counted as one underrun, and
+// that no frame waits behind AUDIO_RING_FRAMES or more, the latency bound.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include "config.h"
+#include "pcm_ring_buffer.h"
+
+static PcmRingBuffer<AUDIO_RING_FRAMES> ring;
+static_assert(AUDIO_RING_FRAMES < 32768, "the frames carry 16-bit indices");
+
+static Frame frameFor(uint32_t sequence, uint32_t readIndex) {
+    return Frame(static_cast<int16_t>(sequence & 0xFFFF), static_cast<int16_t>(readIndex & 0xFFFF));
+}
+
+static uint16_t sequenceOf(const Frame& frame) { return static_cast<uint16_t>(frame.channel1); }
+
+// frames the consumer still had to read before this one when it was written
+static uint16_t waitOf(const Frame& frame) { return sequenceOf(frame) - static_cast<uint16_t>(frame.channel2); }
+
+// random pause of up to maxUs, half of the time none
+static void jitter(std::mt19937& random, int maxUs) {
+    int us = static_cast<int>(random() % (2 * maxUs + 1)) - maxUs;
+    if (us > 0) std::this_thread::sleep_for(std::chrono::microseconds(us));
+    else if (us == 0) std::this_thread::yield();
+}
+
+int main(int argc, char** argv) {
+    const uint32_t total = argc > 1 ? static_cast<uint32_t>(atol(argv[1])) : 2000000;
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        std::mt19937 random(1);
+        uint32_t next = 0;
+        while (next < total) {
+            int32_t count = 1 + random() % 300;
+            if (count > static_cast<int32_t>(total - next)) count = total - next;
+            Frame* region = ring.writeRegion(count);
+            if (count == 0) { // full, the producer task would wait for a notification here
+                jitter(random, 50);
+                continue;
+            }
+            // the read index after the region was granted, it can only have moved on since the grant
+            const uint32_t readIndex = next - ring.available();
+            for (int32_t i = 0; i < count; i++) region[i] = frameFor(next + i, readIndex);
+            ring.commit(count);
+            next += count;
+            if (random() % 8 == 0) jitter(random, 400); // a late producer, forces underruns
+        }
+        done = true;
+    });
+
+    std::mt19937 random(2);
+    static Frame block[512];
+    uint32_t expected = 0, shortReads = 0, errors = 0, worstWait = 0;
+    while (expected < total) {
+        const bool finished = done;
+        const int32_t count = 16 + random() % 497;
+        const int32_t n = ring.read(block, count);
+        for (int32_t i = 0; i < n; i++) {
+            if (sequenceOf(block[i]) != static_cast<uint16_t>(expected + i) && errors++ < 5) {
+                printf("frame %u: got %u\n", expected + i, sequenceOf(block[i]));
+            }
+            worstWait = std::max<uint32_t>(worstWait, waitOf(block[i]));
+        }
+        for (int32_t i = n; i < count; i++) {
+            if ((block[i].channel1 || block[i].channel2) && errors++ < 5) printf("padding frame %d is not silent\n", i);
+        }
+        if (n < count) shortReads++;
+        expected += n;
+        if (n == 0 && finished) break;
+        jitter(random, 100);
+    }
+    producer.join();
+
+    bool pass = errors == 0 && expected == total && ring.getUnderruns() == shortReads && ring.available() == 0;
+    printf("ring order: %u frames, %u short reads, %u underruns counted, %u errors  %s\n", expected, shortReads,
+           ring.getUnderruns(), errors, pass ? "PASS" : "FAIL");
+    const bool latencyOk = worstWait < AUDIO_RING_FRAMES;
+    printf("ring latency: longest wait %u frames (%.1f ms), bound %u frames (%.1f ms)  %s\n", worstWait,
+           worstWait * 1000.0 / AUDIO_SAMPLE_RATE, AUDIO_RING_FRAMES, AUDIO_RING_FRAMES * 1000.0 / AUDIO_SAMPLE_RATE,
+           latencyOk ? "PASS" : "FAIL");
+    pass = pass && latencyOk;
+    printf("ring buffer: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// Test of the sample-rate templates: the pink and brown generators, float and
+// integer, are instantiated at 16, 22.05, 44.1 and 48 kHz and their PSD slope
+// is fitted over half-octave bands from 40 Hz to 0.4 fs. Pink has to be within
+// 0.15 dB/octave of -3 and brown within 0.3 of -6, and the brown level in the
+// 200-400 Hz band within 0.5 dB of its level at 44.1 kHz, so a rate change
+// keeps the sound and not only the slope.
+//
+//   test_sample_rates [seconds per generator]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "pink_noise.h"
+#include "spectrum.h"
+
+static const int FFT_SIZE = 16384;
+static bool pass = true;
+
+struct Measurement {
+    double slope;
+    double deviation;
+    double levelPerHz; // dB, 200-400 Hz
+};
+
+// renders seconds of a generator and fits its spectrum
+template <typename Generator>
+static Measurement measure(Generator& generator, double sampleRate, double seconds) {
+    WelchPsd psd(FFT_SIZE);
+    Frame frames[256];
+    generator.random().seed(7);
+    for (int64_t rendered = 0; rendered < static_cast<int64_t>(seconds * sampleRate); rendered += 256) {
+        generator.renderBlock(frames, 256);
+        for (const Frame& frame : frames) psd.add(frame.channel1 / 32768.0);
+    }
+    std::vector<double> bands, levels;
+    for (double low = 40.0; low * M_SQRT2 <= 0.4 * sampleRate; low *= M_SQRT2) {
+        bands.push_back(log2(low));
+        levels.push_back(psd.bandLevel(low, low * M_SQRT2, sampleRate));
+    }
+    const LineFit fit = fitLine(bands, levels);
+    return {fit.slope, fit.deviation, psd.bandLevel(200.0, 400.0, sampleRate) - 10.0 * log10(sampleRate)};
+}
+
+// level is NAN when it is not checked
+static void expect(const char* name, uint32_t sampleRate, const Measurement& m, double slope, double slopeTolerance, double level) {
+    const bool ok = fabs(m.slope - slope) <= slopeTolerance && (std::isnan(level) || fabs(m.levelPerHz - level) <= 0.5);
+    printf("%-24s %5u Hz  slope %+6.3f dB/oct (%+.1f +/- %.2f)  band dev %.2f dB  level %+6.1f dB/Hz  %s\n", name, sampleRate,
+           m.slope, slope, slopeTolerance, m.deviation, m.levelPerHz, ok ? "PASS" : "FAIL");
+    pass = pass && ok;
+}
+
+template <uint32_t SampleRate>
+static void check(double seconds, double brownLevel, double brownFixedLevel) {
+    static PinkNoiseFilterV2<SampleRate> pink;
+    static PinkNoiseFilterFixed<SampleRate> pinkFixed;
+    static BrownNoiseGenerator<SampleRate> brown;
+    static BrownNoiseGeneratorFixed<SampleRate> brownFixed;
+    const Measurement p = measure(pink, SampleRate, seconds);
+    const Measurement pf = measure(pinkFixed, SampleRate, seconds);
+    const Measurement b = measure(brown, SampleRate, seconds);
+    const Measurement bf = measure(brownFixed, SampleRate, seconds);
+    expect("PinkNoiseFilterV2", SampleRate, p, -3.0, 0.15, NAN); // the white taps spread the level over the band
+    expect("PinkNoiseFilterFixed", SampleRate, pf, -3.0, 0.15, NAN);
+    expect("BrownNoiseGenerator", SampleRate, b, -6.0, 0.3, brownLevel);
+    expect("BrownNoiseGeneratorFixed", SampleRate, bf, -6.0, 0.3, brownFixedLevel);
+}
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? atof(argv[1]) : 40.0;
+    static BrownNoiseGenerator<44100> brown;
+    static BrownNoiseGeneratorFixed<44100> brownFixed;
+    const double brownLevel = measure(brown, 44100, seconds).levelPerHz;
+    const double brownFixedLevel = measure(brownFixed, 44100, seconds).levelPerHz;
+    check<16000>(seconds, brownLevel, brownFixedLevel);
+    check<22050>(seconds, brownLevel, brownFixedLevel);
+    check<44100>(seconds, brownLevel, brownFixedLevel);
+    check<48000>(seconds, brownLevel, brownFixedLevel);
+    printf("sample rates: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
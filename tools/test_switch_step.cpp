@@ -0,0 +1,96 @@
+// Test of algorithm switches through the player's render path: the largest
+// sample-to-sample step while a crossfade runs must stay within STEP_RATIO of
+// the largest step either algorithm makes on its own, so a switch never
+// clicks. Every ordered pair of algorithms is switched, once with the default
+// soundscape layers (brown and pink filter v2, shared with those algorithms)
+// and once with the tone layer turned up, so a switch between the soundscape
+// and a generator it shares is covered for noise and for a tone. Last, a sound
+// in two layers of the soundscape has to play as smoothly as on its own.
+//
+//   test_switch_step
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "audio_player.h"
+
+static const int SETTLE_BLOCKS = 200;
+static const int STEADY_BLOCKS = 200;
+static const int SWITCH_BLOCKS = (NOISE_CROSSFADE_MS * AUDIO_SAMPLE_RATE / 1000) / 256 + 8; // the whole crossfade
+static const double STEP_RATIO = 1.5; // equal-power sum of two steps is at most sqrt(2) of the larger one
+static const int STEP_SLACK = 64;     // silence and quiet tones
+
+static Frame block[256];
+static Frame last;
+
+// renders blocks, returns the largest step between consecutive samples of either channel
+static int render(int blocks) {
+    int worst = 0;
+    for (int b = 0; b < blocks; b++) {
+        AudioPlayer::renderFrames(block, 256);
+        for (const Frame& frame : block) {
+            worst = std::max(worst, abs(frame.channel1 - last.channel1));
+            worst = std::max(worst, abs(frame.channel2 - last.channel2));
+            last = frame;
+        }
+    }
+    return worst;
+}
+
+int main() {
+    seed_noise_generators();
+    AudioPlayer player;
+    player.setStereo(true);
+
+    // largest step of each algorithm on its own
+    std::vector<int> steady(NOISE_ALGORITHM_COUNT);
+    for (int alg = 0; alg < NOISE_ALGORITHM_COUNT; alg++) {
+        player.setAlgorithm(alg);
+        render(SETTLE_BLOCKS);
+        steady[alg] = render(STEADY_BLOCKS);
+    }
+
+    bool pass = true;
+    int checked = 0;
+    for (int shared = 0; shared < 2; shared++) {
+        if (shared) player.setLayer(2, find_noise_algorithm("Tone"), 0.5f); // a default layer plus the tone
+        for (int from = 0; from < NOISE_ALGORITHM_COUNT; from++) {
+            for (int to = 0; to < NOISE_ALGORITHM_COUNT; to++) {
+                if (from == to) continue;
+                player.setAlgorithm(from);
+                render(SETTLE_BLOCKS);
+                const int before = render(STEADY_BLOCKS / 4);
+                player.setAlgorithm(to);
+                const int during = render(SWITCH_BLOCKS);
+                const int after = render(STEADY_BLOCKS / 4);
+                const int limit = static_cast<int>(STEP_RATIO * std::max({steady[from], steady[to], before, after})) + STEP_SLACK;
+                checked++;
+                if (during > limit) {
+                    printf("%s%s -> %s: step %d during the switch, limit %d (steady %d / %d)  FAIL\n", shared ? "[tone layer] " : "",
+                           noiseAlgorithms[from].name, noiseAlgorithms[to].name, during, limit, steady[from], steady[to]);
+                    pass = false;
+                } else if (!strcmp(noiseAlgorithms[from].name, "Soundscape") || !strcmp(noiseAlgorithms[to].name, "Soundscape")) {
+                    printf("%s%s -> %s: step %d during the switch, limit %d  PASS\n", shared ? "[tone layer] " : "",
+                           noiseAlgorithms[from].name, noiseAlgorithms[to].name, during, limit);
+                }
+            }
+        }
+    }
+
+    // the same generator in two layers, each at half gain
+    const int soundscape = find_noise_algorithm("Soundscape");
+    for (const char* name : {"Brown", "Tone"}) {
+        const int alg = find_noise_algorithm(name);
+        player.setLayer(0, alg, 0.5f);
+        player.setLayer(1, alg, 0.5f);
+        for (int i = 2; i < NoiseMixer::LAYERS; i++) player.setLayer(i, -1, 0.0f);
+        player.setAlgorithm(soundscape);
+        render(SETTLE_BLOCKS + SWITCH_BLOCKS);
+        const int step = render(STEADY_BLOCKS);
+        const int limit = static_cast<int>(STEP_RATIO * steady[alg]) + STEP_SLACK;
+        printf("%s in two layers: step %d, limit %d  %s\n", name, step, limit, step <= limit ? "PASS" : "FAIL");
+        pass = pass && step <= limit;
+    }
+    printf("switch step: %d switches  %s\n", checked, pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+// Test of the tone settings as they arrive from the web interface and the API:
+// carrier and beat are clamped to their ranges, NaN takes the lower bound and
+// the beat stays below twice the carrier, so the lower ear of a binaural beat
+// plays TONE_MIN_EAR_HZ or more. The ear frequencies are measured by counting
+// zero crossings of the rendered tone.
+//
+//   test_tone
+
+#include <cmath>
+#include <cstdio>
+#include "tone_generator.h"
+
+static bool pass = true;
+
+// frequency of a channel from its rising zero crossings over seconds of audio
+static double measureHz(ToneGenerator& tone, bool right, double seconds) {
+    static float left[256], rightOut[256];
+    float last = 0.0f;
+    int crossings = 0;
+    const int32_t blocks = static_cast<int32_t>(seconds * AUDIO_SAMPLE_RATE / 256);
+    for (int32_t b = 0; b < blocks; b++) {
+        tone.renderBlock(left, rightOut, 256);
+        const float* samples = right ? rightOut : left;
+        for (int i = 0; i < 256; i++) {
+            if (last < 0.0f && samples[i] >= 0.0f) crossings++;
+            last = samples[i];
+        }
+    }
+    return crossings / (blocks * 256.0 / AUDIO_SAMPLE_RATE);
+}
+
+int main() {
+    struct Case {
+        float carrier, beat;
+        float expectedCarrier, expectedBeat;
+    } cases[] = {
+        {200, 10, 200, 10},
+        {5, 10, 20, 10},
+        {3000, 10, 1500, 10},
+        {200, -5, 200, 0},
+        {200, 100, 200, 40},
+        {20, 40, 20, 2 * (20 - TONE_MIN_EAR_HZ)}, // the lower ear would be 0 Hz
+        {25, 40, 25, 2 * (25 - TONE_MIN_EAR_HZ)},
+        {30, 40, 30, 40},
+        {NAN, 10, 20, 10},
+        {200, NAN, 200, 0},
+        {INFINITY, INFINITY, 1500, 40},
+        {-INFINITY, -INFINITY, 20, 0},
+    };
+
+    ToneGenerator tone;
+    for (const Case& c : cases) {
+        tone.setTone(c.carrier, c.beat, ToneGenerator::BINAURAL);
+        const bool ok = tone.getCarrier() == c.expectedCarrier && tone.getBeat() == c.expectedBeat;
+        printf("carrier %7.1f beat %6.1f -> %6.1f %5.1f Hz  %s\n", c.carrier, c.beat, tone.getCarrier(), tone.getBeat(), ok ? "PASS" : "FAIL");
+        pass = pass && ok;
+    }
+
+    // the lowest carrier with the fastest beat, both ears at the frequency they should play
+    tone.setTone(20, 40, ToneGenerator::BINAURAL);
+    const double leftHz = measureHz(tone, false, 20.0), rightHz = measureHz(tone, true, 20.0);
+    const bool earsOk = fabs(leftHz - TONE_MIN_EAR_HZ) < 0.2 && fabs(rightHz - 30.0) < 0.2;
+    printf("carrier 20 Hz, beat 40 Hz: left ear %.2f Hz, right ear %.2f Hz  %s\n", leftHz, rightHz, earsOk ? "PASS" : "FAIL");
+    pass = pass && earsOk;
+
+    printf("tone: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
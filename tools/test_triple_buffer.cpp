@@ -0,0 +1,64 @@
+// Stress test of the coefficient handoff: a writer thread publishes designs in
+// quick bursts, like a slider dragged in the web interface, while a reader
+// thread takes the newest at block start and reads it for a whole block. Every
+// design is filled with its sequence number, so a design written while it is
+// being read shows up as mixed values.
+//
+//   test_triple_buffer [designs]
+//
+// Checks that no block sees a torn design, that the reader never goes back to
+// an older one and that it ends on the last one published.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include "triple_buffer.h"
+
+struct Design {
+    uint32_t values[64];
+};
+
+static TripleBuffer<Design> designs;
+
+int main(int argc, char** argv) {
+    const uint32_t total = argc > 1 ? static_cast<uint32_t>(atol(argv[1])) : 200000;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        std::mt19937 random(1);
+        for (uint32_t sequence = 1; sequence <= total; sequence++) {
+            Design& design = designs.writeBuffer();
+            for (uint32_t& v : design.values) v = sequence;
+            designs.publish();
+            if (random() % 64 == 0) std::this_thread::yield(); // between bursts
+        }
+        done = true;
+    });
+
+    uint32_t blocks = 0, updates = 0, torn = 0, backwards = 0, last = 0;
+    for (;;) {
+        const bool finished = done;
+        const bool taken = designs.update();
+        if (taken) updates++;
+        const Design& design = designs.read();
+        const uint32_t sequence = design.values[0];
+        // a block renders with the design for a while, it must not change under it
+        for (int pass = 0; pass < 4; pass++) {
+            for (uint32_t v : design.values) {
+                if (v != sequence) torn++;
+            }
+        }
+        if (sequence < last) backwards++;
+        last = sequence;
+        blocks++;
+        if (finished && !taken) break; // nothing newer left after the writer ended
+    }
+    writer.join();
+
+    const bool pass = torn == 0 && backwards == 0 && last == total && designs.latest().values[0] == total;
+    printf("triple buffer: %u designs, %u blocks, %u updates taken, %u torn values, %u steps back, last %u  %s\n", total,
+           blocks, updates, torn, backwards, last, pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
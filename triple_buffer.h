@@ -0,0 +1,46 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// lock-free single-writer/single-reader handoff of a value, e.g. filter
+// coefficients designed in the control task for the render path. The writer
+// fills its own buffer and swaps it into the middle slot, the reader swaps the
+// middle slot with its own at block start. Neither side waits, and a buffer is
+// only written after the reader has handed it back, so any number of quick
+// updates can never tear the one being rendered; the reader gets the newest.
+template <typename T>
+class TripleBuffer {
+private:
+    static const int FRESH = 4; // middle slot holds a value the reader has not taken yet
+
+    T buffers[3];
+    std::atomic<int> middle{1};
+    int back = 2;      // writer only
+    int published = 0; // writer only, the last buffer it handed over
+    int front = 0;     // reader only
+
+public:
+    // writer: the buffer to fill, then publish() it
+    T& writeBuffer() { return buffers[back]; }
+
+    void publish() {
+        published = back;
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    // writer: the value it published last, it is only read until the next publish
+    const T& latest() const { return buffers[published]; }
+
+    // reader: take the newest published value, true when there was one
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+        return true;
+    }
+
+    // reader: the value in use
+    const T& read() const { return buffers[front]; }
+};
+
+#endif
@@ -75,6 +75,16 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             background: #cccccc;
             cursor: not-allowed;
         }
+        .settings {
+            margin-top: 20px;
+        }
+        .setting-item {
+            display: flex;
+            justify-content: space-between;
+            align-items: center;
+            padding: 10px 0;
+            border-bottom: 1px solid #eee;
+        }
     </style>
 </head>
 <body>
@@ -85,6 +95,103 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             <div class="loading">Loading device list...</div>
         </div>
     </div>
+    <div class="device-list settings">
+        <h2>Sound Settings</h2>
+        <label class="setting-item">Stereo noise (independent left/right)
+            <input type="checkbox" data-setting="stereo">
+        </label>
+        <label class="setting-item">Volume
+            <input type="range" min="0" max="400" data-setting="volume">
+        </label>
+        <label class="setting-item">Custom noise slope (dB/octave)
+            <input type="number" min="-12" max="12" step="0.5" data-setting="slope">
+        </label>
+        <label class="setting-item">Tone mode
+            <select data-setting="toneMode">
+                <option value="0">Binaural beat</option>
+                <option value="1">Isochronic pulse</option>
+            </select>
+        </label>
+        <label class="setting-item">Tone carrier (Hz)
+            <input type="number" min="20" max="1500" step="1" data-setting="toneHz">
+        </label>
+        <label class="setting-item">Beat / pulse rate (Hz)
+            <input type="number" min="0" max="40" step="0.5" data-setting="beatHz" id="beatHz">
+        </label>
+        <label class="setting-item">Soundscape layer 1
+            <select class="algorithm-select" data-setting="layer0"></select>
+            <input type="range" min="0" max="100" data-setting="layer0Gain">
+        </label>
+        <label class="setting-item">Soundscape layer 2
+            <select class="algorithm-select" data-setting="layer1"></select>
+            <input type="range" min="0" max="100" data-setting="layer1Gain">
+        </label>
+        <label class="setting-item">Soundscape layer 3
+            <select class="algorithm-select" data-setting="layer2"></select>
+            <input type="range" min="0" max="100" data-setting="layer2Gain">
+        </label>
+        <label class="setting-item">Soundscape layer 4
+            <select class="algorithm-select" data-setting="layer3"></select>
+            <input type="range" min="0" max="100" data-setting="layer3Gain">
+        </label>
+        <label class="setting-item">EQ band 1
+            <select data-setting="eq0Type">
+                <option value="0">Off</option>
+                <option value="1">Low shelf</option>
+                <option value="2">High shelf</option>
+                <option value="3">Peaking</option>
+                <option value="4">High-pass</option>
+                <option value="5">Low-pass</option>
+            </select>
+            <input type="number" min="20" max="19000" step="1" title="Hz" data-setting="eq0Hz">
+            <input type="number" min="-18" max="18" step="0.5" title="dB" data-setting="eq0Db">
+            <input type="number" min="0.1" max="10" step="0.1" title="Q" data-setting="eq0Q">
+        </label>
+        <label class="setting-item">EQ band 2
+            <select data-setting="eq1Type">
+                <option value="0">Off</option>
+                <option value="1">Low shelf</option>
+                <option value="2">High shelf</option>
+                <option value="3">Peaking</option>
+                <option value="4">High-pass</option>
+                <option value="5">Low-pass</option>
+            </select>
+            <input type="number" min="20" max="19000" step="1" title="Hz" data-setting="eq1Hz">
+            <input type="number" min="-18" max="18" step="0.5" title="dB" data-setting="eq1Db">
+            <input type="number" min="0.1" max="10" step="0.1" title="Q" data-setting="eq1Q">
+        </label>
+        <label class="setting-item">EQ band 3
+            <select data-setting="eq2Type">
+                <option value="0">Off</option>
+                <option value="1">Low shelf</option>
+                <option value="2">High shelf</option>
+                <option value="3">Peaking</option>
+                <option value="4">High-pass</option>
+                <option value="5">Low-pass</option>
+            </select>
+            <input type="number" min="20" max="19000" step="1" title="Hz" data-setting="eq2Hz">
+            <input type="number" min="-18" max="18" step="0.5" title="dB" data-setting="eq2Db">
+            <input type="number" min="0.1" max="10" step="0.1" title="Q" data-setting="eq2Q">
+        </label>
+        <label class="setting-item">EQ band 4
+            <select data-setting="eq3Type">
+                <option value="0">Off</option>
+                <option value="1">Low shelf</option>
+                <option value="2">High shelf</option>
+                <option value="3">Peaking</option>
+                <option value="4">High-pass</option>
+                <option value="5">Low-pass</option>
+            </select>
+            <input type="number" min="20" max="19000" step="1" title="Hz" data-setting="eq3Hz">
+            <input type="number" min="-18" max="18" step="0.5" title="dB" data-setting="eq3Db">
+            <input type="number" min="0.1" max="10" step="0.1" title="Q" data-setting="eq3Q">
+        </label>
+        <div class="setting-item">Uploaded loop (44.1 kHz mono IMA-ADPCM WAV, see tools/encode_adpcm)
+            <input type="file" id="loopFile" accept=".wav">
+            <button type="button" class="button" onclick="uploadLoop()">Upload</button>
+            <span id="loopStatus"></span>
+        </div>
+    </div>
     <a href="/update">Firmware Update</a>
 
     <script>
@@ -167,8 +274,81 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             }
         }
 
+        // inputs marked with data-setting are loaded from and saved to /api/settings
+        async function loadSettings() {
+            try {
+                const response = await fetch('/api/settings');
+                const settings = await response.json();
+                // soundscape layer sources are picked from the player's sound list
+                document.querySelectorAll('.algorithm-select').forEach(select => {
+                    select.innerHTML = '<option value="-1">(none)</option>';
+                    (settings.algorithms || []).forEach((name, index) => {
+                        select.add(new Option(name, index));
+                    });
+                });
+                if (settings.loopSeconds !== undefined) {
+                    document.getElementById('loopStatus').textContent =
+                        settings.loopSeconds > 0 ? settings.loopSeconds.toFixed(1) + ' s loop stored' : 'no loop stored';
+                }
+                document.querySelectorAll('[data-setting]').forEach(input => {
+                    const value = settings[input.dataset.setting];
+                    if (value === undefined) return;
+                    if (input.type === 'checkbox') input.checked = value;
+                    else input.value = value;
+                });
+                limitBeat();
+            } catch (error) {
+                console.error('Error loading settings:', error);
+            }
+        }
+
+        async function uploadLoop() {
+            const file = document.getElementById('loopFile').files[0];
+            const status = document.getElementById('loopStatus');
+            if (!file) return;
+            const form = new FormData();
+            form.append('loop', file);
+            status.textContent = 'Uploading...';
+            try {
+                const response = await fetch('/api/loop', { method: 'POST', body: form });
+                const result = await response.json();
+                if (result.status !== 'ok') throw new Error(result.message);
+                await loadSettings();
+            } catch (error) {
+                status.textContent = 'Upload failed: ' + error.message;
+            }
+        }
+
+        // the beat stays below twice the carrier, the lower ear at 10 Hz (TONE_MIN_EAR_HZ) or above
+        function limitBeat() {
+            const carrier = Number(document.querySelector('[data-setting="toneHz"]').value);
+            document.getElementById('beatHz').max = Math.max(0, Math.min(40, 2 * (carrier - 10)));
+        }
+
+        async function saveSetting(input) {
+            const value = input.type === 'checkbox' ? input.checked : Number(input.value);
+            try {
+                await fetch('/api/settings', {
+                    method: 'POST',
+                    headers: {
+                        'Content-Type': 'application/json',
+                    },
+                    body: JSON.stringify({ [input.dataset.setting]: value })
+                });
+                // show what the firmware kept, e.g. a beat limited by a lower carrier
+                if (input.dataset.setting === 'toneHz' || input.dataset.setting === 'beatHz') await loadSettings();
+            } catch (error) {
+                console.error('Error saving setting:', error);
+            }
+        }
+
+        document.querySelectorAll('[data-setting]').forEach(input => {
+            input.onchange = () => saveSetting(input);
+        });
+
         document.getElementById('refreshBtn').onclick = rescan;
         loadDevices();
+        loadSettings();
     </script>
 </body>
 </html>
@@ -29,6 +29,11 @@ private:
     DNSServer dnsServer;
     const std::vector<std::string>* btDevices;
     std::function<void(WifiState, const char*)> onWifiStateChanged;
+    std::function<void(JsonObject&)> onReadSettings;
+    std::function<void(JsonObject&)> onWriteSettings;
+    std::function<void(JsonObject&)> onReadStats;
+    std::function<bool(size_t, const uint8_t*, size_t, bool)> onLoopUpload;
+    bool loopUploadOk = false;
 
 public:
     WifiManager() : server(80) {}
@@ -55,6 +60,22 @@ public:
         server.begin();
     }
 
+    // sound settings shown on the web page, read fills the object and write applies it
+    void setSettingsCallbacks(std::function<void(JsonObject&)> read, std::function<void(JsonObject&)> write) {
+        onReadSettings = read;
+        onWriteSettings = write;
+    }
+
+    // runtime statistics served at /api/stats
+    void setStatsCallback(std::function<void(JsonObject&)> read) {
+        onReadStats = read;
+    }
+
+    // ambient loop uploaded at /api/loop, called per chunk with its offset, data and whether it is the last one
+    void setLoopUploadCallback(std::function<bool(size_t, const uint8_t*, size_t, bool)> write) {
+        onLoopUpload = write;
+    }
+
     void stop() {
         delay(100);
         server.end();
@@ -147,6 +168,49 @@ private:
         );
 
         server.addHandler(selectHandler);
+
+        // sound settings
+        server.on("/api/settings", HTTP_GET, [this](AsyncWebServerRequest *request){
+            AsyncResponseStream *response = request->beginResponseStream("application/json");
+            DynamicJsonDocument doc(2048);
+            JsonObject settings = doc.to<JsonObject>();
+            if (onReadSettings) onReadSettings(settings);
+            serializeJson(doc, *response);
+            request->send(response);
+        });
+
+        AsyncCallbackJsonWebHandler* settingsHandler = new AsyncCallbackJsonWebHandler(
+            "/api/settings",
+            [this](AsyncWebServerRequest *request, JsonVariant &json) {
+                if (json.is<JsonObject>()) {
+                    JsonObject jsonObj = json.as<JsonObject>();
+                    if (onWriteSettings) onWriteSettings(jsonObj);
+                    request->send(200, "application/json", "{\"status\":\"ok\"}");
+                } else {
+                    request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON format\"}");
+                }
+            }
+        );
+        server.addHandler(settingsHandler);
+
+        server.on("/api/stats", HTTP_GET, [this](AsyncWebServerRequest *request){
+            AsyncResponseStream *response = request->beginResponseStream("application/json");
+            DynamicJsonDocument doc(768);
+            JsonObject stats = doc.to<JsonObject>();
+            if (onReadStats) onReadStats(stats);
+            serializeJson(doc, *response);
+            request->send(response);
+        });
+
+        server.on("/api/loop", HTTP_POST,
+            [this](AsyncWebServerRequest *request) {
+                if (loopUploadOk) request->send(200, "application/json", "{\"status\":\"ok\"}");
+                else request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Not a 44.1 kHz mono IMA-ADPCM WAV, or it does not fit\"}");
+            },
+            [this](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+                if (index == 0) loopUploadOk = true;
+                if (loopUploadOk) loopUploadOk = onLoopUpload && onLoopUpload(index, data, len, final);
+            });
         
     }
 };